@@ -1,4 +1,6 @@
 #include <opencv2/opencv.hpp>
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
 #include "core/Utility.h"
 #include <assert.h>
 
@@ -19,34 +21,46 @@ static cv::Mat MakeCorrelation(cv::Mat image, cv::Mat mask)
         cv::split(fmask, lmask);
     }
 
-    cv::Mat res = cv::Mat::zeros(image.rows, image.cols, CV_32F);
+    // Channels are correlated as independent tasks, shown in order afterwards
+    std::vector<cv::Mat> correlation(3);
+    core::TaskGroup group;
     for (int i = 0; i < 3; i++)
     {
-        limage[i] /= 255;
-        lmask[i] /= 255;
-        auto mean = cv::mean(lmask[i]);
-        limage[i] -= mean;
-        lmask[i] -= mean;
-
-        cv::Mat ilayer, flayer;
-        cv::copyMakeBorder(lmask[i], flayer,
-                0, image.rows - mask.rows,
-                0, image.cols - mask.cols,
-                cv::BORDER_CONSTANT);
-
-        cv::merge(std::vector<cv::Mat>{limage[i], cv::Mat::zeros(limage[i].size(), CV_32F)}, ilayer);
-        cv::merge(std::vector<cv::Mat>{flayer, cv::Mat::zeros(flayer.size(), CV_32F)}, flayer);
-        cv::dft(ilayer, ilayer);
-        cv::dft(flayer, flayer);
-        cv::mulSpectrums(ilayer, flayer, ilayer, 0);
-        cv::dft(ilayer, ilayer, cv::DFT_INVERSE);
+        group.Run([&, i]() {
+            core::TraceZone channelZone("Correlate channel");
+            limage[i] /= 255;
+            lmask[i] /= 255;
+            auto mean = cv::mean(lmask[i]);
+            limage[i] -= mean;
+            lmask[i] -= mean;
+
+            cv::Mat& ilayer = correlation[i];
+            cv::Mat flayer;
+            cv::copyMakeBorder(lmask[i], flayer,
+                    0, image.rows - mask.rows,
+                    0, image.cols - mask.cols,
+                    cv::BORDER_CONSTANT);
+
+            cv::merge(std::vector<cv::Mat>{limage[i], cv::Mat::zeros(limage[i].size(), CV_32F)}, ilayer);
+            cv::merge(std::vector<cv::Mat>{flayer, cv::Mat::zeros(flayer.size(), CV_32F)}, flayer);
+            cv::dft(ilayer, ilayer);
+            cv::dft(flayer, flayer);
+            cv::mulSpectrums(ilayer, flayer, ilayer, 0);
+            cv::dft(ilayer, ilayer, cv::DFT_INVERSE);
         
-        std::vector<cv::Mat> tmp(2);
-        cv::split(ilayer, tmp);
-        ilayer = tmp[0];
+            std::vector<cv::Mat> tmp(2);
+            cv::split(ilayer, tmp);
+            ilayer = tmp[0];
 
-        assert(ilayer.type() == CV_32F);
+            assert(ilayer.type() == CV_32F);
+        });
+    }
+    group.Wait();
 
+    cv::Mat res = cv::Mat::zeros(image.rows, image.cols, CV_32F);
+    for (int i = 0; i < 3; i++)
+    {
+        const cv::Mat& ilayer = correlation[i];
         // Show output for spewcific layer
         cv::Mat outputForLayer;
         cv::normalize(ilayer, outputForLayer, 0, 1, CV_MINMAX);
@@ -57,6 +71,7 @@ static cv::Mat MakeCorrelation(cv::Mat image, cv::Mat mask)
 
     cv::Mat shiftedOutput(res.size(), CV_32F);
     // Shift image
+    core::TraceZone shiftZone("Shift");
     int shiftX = mask.cols / 2;
     int shiftY = mask.rows / 2;
     for (int r = 0, tr = res.rows - shiftY; r < res.rows; r++, tr++)
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <exception>
+#include "core/Trace.h"
 #include "core/Utility.h"
 #include "third_party/gnuplot.h"
 #include <sstream>
@@ -8,6 +9,7 @@ const char* BGR[3] = {"Blue", "Green", "Red"};
 
 void OutputChannel(GnuplotPipe& gnuPlot, cv::Mat& mat, int channel)
 {
+    core::TraceZone zone("Plot channel");
     for (int i = 0; i < mat.rows; i++)
     {
         cv::Vec3b *cRow = mat.ptr<cv::Vec3b>(i);;
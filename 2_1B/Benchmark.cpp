@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
+#include "core/Utility.h"
+#include "Particles.h"
+#include "SpatialGrid.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const char* USAGE = "Usage: ./2_1b_bench [--grid] [--particles N] [--steps S] [--dt seconds] "
+                        "[--seed S] [--threads T]";
+
+    // Grid benchmark: interaction radius equal to the cell size and about 8
+    // neighbours inside it
+    const float GRID_RADIUS = 1;
+    const double GRID_DENSITY = 2;
+    const size_t GRID_MIN_PARTICLES = 10000;
+    // Each size repeats until about this many particles were processed
+    const size_t GRID_WORK = 10000000;
+
+    struct Options{
+        size_t particles = 10000000;
+        int steps = 100;
+        float dt = 1.0f / 60;
+        uint64_t seed = 1;
+        // Set by the global --threads option
+        unsigned threads = core::ThreadCount();
+        bool grid = false;
+    };
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--grid")
+            {
+                options.grid = true;
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                throw GrafikaException("Missing value for " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--particles")
+            {
+                options.particles = std::stoull(value);
+            }
+            else if (arg == "--steps")
+            {
+                options.steps = std::atoi(value.c_str());
+            }
+            else if (arg == "--dt")
+            {
+                options.dt = std::stof(value);
+            }
+            else if (arg == "--seed")
+            {
+                options.seed = std::stoull(value);
+            }
+            else
+            {
+                throw GrafikaException(USAGE);
+            }
+        }
+        if (options.particles == 0 || options.particles > UINT32_MAX || options.steps <= 0)
+        {
+            throw GrafikaException("Particle count must be in [1; 2^32) and step count positive");
+        }
+        return options;
+    }
+
+    // Sum of a linear repulsion from all neighbours closer than GRID_RADIUS,
+    // for each particle in cell order. Returns the number of neighbours.
+    size_t Repulsion(const SpatialGrid& grid, unsigned threads, std::vector<float>& force)
+    {
+        core::TraceZone zone("Repulsion");
+        const size_t n = grid.Count();
+        const float* x = grid.SortedX();
+        const float* y = grid.SortedY();
+        const float* z = grid.SortedZ();
+        const size_t workers = std::min<size_t>(threads, std::max<size_t>(1, n / GRID_MIN_PARTICLES));
+        std::vector<size_t> neighbours(workers, 0);
+
+        core::ParallelFor(0, workers, 1, [&](size_t w, size_t) {
+            size_t found = 0;
+            for (size_t k = n * w / workers; k < n * (w + 1) / workers; k++)
+            {
+                float sum = 0;
+                grid.ForEachCandidate(x[k], y[k], z[k], [&](uint32_t, float ox, float oy, float oz) {
+                    const float dx = ox - x[k], dy = oy - y[k], dz = oz - z[k];
+                    const float d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 < GRID_RADIUS * GRID_RADIUS)
+                    {
+                        sum += GRID_RADIUS - sqrtf(d2);
+                        found++;
+                    }
+                });
+                force[k] = sum;
+            }
+            neighbours[w] = found;
+        });
+
+        size_t total = 0;
+        for (size_t count : neighbours)
+        {
+            total += count;
+        }
+        // Every particle finds itself
+        return total - n;
+    }
+
+    // Rebuild and query times of the grid for 10^4 .. options.particles
+    // particles spread uniformly with constant density
+    void GridBenchmark(const Options& options)
+    {
+        printf("%u threads, radius %g, density %g\n", options.threads, static_cast<double>(GRID_RADIUS), GRID_DENSITY);
+        printf("%10s %12s %12s %12s %12s %12s\n", "particles", "build ms", "build ns/p", "query ms", "query ns/p",
+               "neighbours");
+        for (size_t n = GRID_MIN_PARTICLES; n <= options.particles; n *= 10)
+        {
+            std::mt19937_64 generator(options.seed);
+            const float side = static_cast<float>(cbrt(static_cast<double>(n) / GRID_DENSITY));
+            std::uniform_real_distribution<float> coordinate(0, side);
+            std::vector<float> x(n), y(n), z(n), force(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                x[i] = coordinate(generator);
+                y[i] = coordinate(generator);
+                z[i] = coordinate(generator);
+            }
+
+            SpatialGrid grid(GRID_RADIUS, options.threads);
+            const size_t repeats = std::max<size_t>(1, GRID_WORK / n);
+            double buildSeconds = 0, querySeconds = 0;
+            size_t neighbours = 0;
+            for (size_t r = 0; r < repeats; r++)
+            {
+                const auto start = Clock::now();
+                grid.Build(x.data(), y.data(), z.data(), n);
+                const auto built = Clock::now();
+                neighbours = Repulsion(grid, options.threads, force);
+                buildSeconds += std::chrono::duration<double>(built - start).count();
+                querySeconds += std::chrono::duration<double>(Clock::now() - built).count();
+            }
+
+            const double perRepeat = 1.0 / static_cast<double>(repeats);
+            printf("%10zu %12.3f %12.2f %12.3f %12.2f %12.2f\n", n,
+                   buildSeconds * perRepeat * 1e3, buildSeconds * perRepeat * 1e9 / static_cast<double>(n),
+                   querySeconds * perRepeat * 1e3, querySeconds * perRepeat * 1e9 / static_cast<double>(n),
+                   static_cast<double>(neighbours) / static_cast<double>(n));
+        }
+    }
+}
+
+int safe_main(int argc, char** argv)
+{
+    const Options options = ParseOptions(argc, argv);
+    if (options.grid)
+    {
+        GridBenchmark(options);
+        return 0;
+    }
+
+    ParticleSystem particles(options.particles, options.seed, options.threads);
+
+    const auto start = Clock::now();
+    for (int i = 0; i < options.steps; i++)
+    {
+        particles.Update(options.dt);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const double updates = static_cast<double>(options.particles) * options.steps;
+    printf("%zu particles, %d steps of %g s, %u threads\n",
+           options.particles, options.steps, static_cast<double>(options.dt), options.threads);
+    printf("%.3f s, %.1f M particles/s, %.2f ns per particle update\n",
+           seconds, updates / seconds / 1e6, seconds * 1e9 / updates);
+    printf("%.2f bytes per particle\n", static_cast<double>(particles.MemoryBytes()) / options.particles);
+    printf("checksum %016llx\n", static_cast<unsigned long long>(particles.Checksum()));
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    return core::CatchExceptions(safe_main, argc, argv);
+}
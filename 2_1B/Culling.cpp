@@ -0,0 +1,93 @@
+#include "Culling.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CULLING_SIMD
+#include <immintrin.h>
+#endif
+
+ViewCulling MakeViewCulling(const float* matrix, const float eye[3], float radius, float lodDistance)
+{
+    // Gribb, Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+    // World-View-Projection Matrix": the last row plus or minus each other row
+    auto row = [&](int r, int c) { return matrix[4 * c + r]; };
+    ViewCulling view;
+    for (int p = 0; p < 6; p++)
+    {
+        const float sign = p % 2 == 0 ? 1.0f : -1.0f;
+        for (int c = 0; c < 4; c++)
+        {
+            view.planes[p][c] = row(3, c) + sign * row(p / 2, c);
+        }
+        const float length = sqrtf(view.planes[p][0] * view.planes[p][0] + view.planes[p][1] * view.planes[p][1] +
+                                   view.planes[p][2] * view.planes[p][2]);
+        for (float& v : view.planes[p])
+        {
+            v /= length;
+        }
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        view.eye[c] = eye[c];
+    }
+    view.radius = radius;
+    view.lodDistance = lodDistance;
+    return view;
+}
+
+void ClassifyParticles(const ViewCulling& view, const float* x, const float* y, const float* z, size_t count,
+                       uint8_t* visibility)
+{
+    const float lod2 = view.lodDistance * view.lodDistance;
+    size_t i = 0;
+
+#ifdef CULLING_SIMD
+    __m128 planes[6][4];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            planes[p][c] = _mm_set1_ps(view.planes[p][c]);
+        }
+    }
+    const __m128 minusRadius = _mm_set1_ps(-view.radius);
+    const __m128 eyeX = _mm_set1_ps(view.eye[0]), eyeY = _mm_set1_ps(view.eye[1]), eyeZ = _mm_set1_ps(view.eye[2]);
+    const __m128 lod2v = _mm_set1_ps(lod2);
+    const __m128i one = _mm_set1_epi32(1);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planes[p][0], px), _mm_mul_ps(planes[p][1], py));
+            distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(planes[p][2], pz)), planes[p][3]);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, minusRadius));
+        }
+        const __m128 dx = _mm_sub_ps(px, eyeX), dy = _mm_sub_ps(py, eyeY), dz = _mm_sub_ps(pz, eyeZ);
+        const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        const __m128i far = _mm_castps_si128(_mm_cmpgt_ps(d2, lod2v));
+
+        // VISIBILITY_NEAR + far where inside, narrowed to bytes
+        const __m128i value = _mm_and_si128(_mm_castps_si128(inside), _mm_add_epi32(one, _mm_and_si128(far, one)));
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(value, value), _mm_setzero_si128());
+        const int packed = _mm_cvtsi128_si32(bytes);
+        memcpy(visibility + i, &packed, 4);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        bool inside = true;
+        for (int p = 0; p < 6; p++)
+        {
+            const float* plane = view.planes[p];
+            inside = inside & (plane[0] * x[i] + plane[1] * y[i] + plane[2] * z[i] + plane[3] >= -view.radius);
+        }
+        const float dx = x[i] - view.eye[0], dy = y[i] - view.eye[1], dz = z[i] - view.eye[2];
+        const bool far = dx * dx + dy * dy + dz * dz > lod2;
+        visibility[i] = static_cast<uint8_t>(inside * (VISIBILITY_NEAR + far));
+    }
+}
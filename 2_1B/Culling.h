@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frustum planes of a view projection matrix and the distance from which
+// particles are drawn as points instead of meshes
+struct ViewCulling{
+    // a, b, c, d with unit normals pointing inside, a x + b y + c z + d >= 0
+    float planes[6][4];
+    float eye[3];
+    // Radius of the particle bounding sphere
+    float radius;
+    float lodDistance;
+};
+
+// matrix is column major, as passed to glUniformMatrix4fv
+ViewCulling MakeViewCulling(const float* matrix, const float eye[3], float radius, float lodDistance);
+
+enum Visibility : uint8_t {
+    VISIBILITY_HIDDEN,
+    VISIBILITY_NEAR,
+    VISIBILITY_FAR,
+};
+
+// Classifies count particles given as separate coordinate arrays, 4 at a
+// time with SSE2
+void ClassifyParticles(const ViewCulling& view, const float* x, const float* y, const float* z, size_t count,
+                       uint8_t* visibility);
@@ -0,0 +1,298 @@
+#include "Particles.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PARTICLES_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+    const float GRAVITY = -10;
+    const float FLOOR_Y = -1;
+    const float SPAWN_Y = -0.5f;
+    const float TWO_PI = 6.28318530718f;
+
+    // Fewer particles are not worth a task of their own
+    const size_t MIN_PARTICLES_PER_THREAD = 1 << 14;
+    // Respawns are sampled in blocks of this size
+    const size_t SAMPLE_BLOCK = 64;
+
+    const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+    // SplitMix64 finalizer
+    uint64_t Mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in (0; 1) from the top 24 bits of a 32 bit word
+    float Uniform(uint32_t bits)
+    {
+        return (static_cast<float>(bits >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+
+#ifdef PARTICLES_SIMD
+    // Cephes logf and sinf / cosf polynomials
+    const float LOG_POLY[] = {7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f,
+                              1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f,
+                              3.3333331174e-1f};
+    const float SIN_POLY[] = {-1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f};
+    const float COS_POLY[] = {2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f};
+
+    __m128 Select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // Natural logarithm of positive normal numbers
+    __m128 Log(__m128 x)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128i bits = _mm_castps_si128(x);
+        __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+        // x = m * 2^e with m in [0.5; 1), then m is moved to [sqrt(0.5); sqrt(2))
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                                 _mm_set1_epi32(0x3f000000)));
+        const __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+        e = _mm_sub_ps(e, _mm_and_ps(small, one));
+        m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), one);
+
+        const __m128 z = _mm_mul_ps(m, m);
+        __m128 y = _mm_set1_ps(LOG_POLY[0]);
+        for (size_t k = 1; k < sizeof(LOG_POLY) / sizeof(LOG_POLY[0]); k++)
+        {
+            y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_POLY[k]));
+        }
+        y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+        y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+        y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        return _mm_add_ps(_mm_add_ps(m, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+    }
+
+    // Sine and cosine of 2 pi t for t in [0; 1]. The nearest quarter turn is
+    // taken out, the rest is within pi / 4 where the polynomials hold.
+    void SinCosTurns(__m128 t, __m128& sine, __m128& cosine)
+    {
+        const __m128i quarter = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(4.0f)), _mm_set1_ps(0.5f)));
+        const __m128 x = _mm_mul_ps(_mm_sub_ps(t, _mm_mul_ps(_mm_cvtepi32_ps(quarter), _mm_set1_ps(0.25f))),
+                                    _mm_set1_ps(TWO_PI));
+        const __m128 x2 = _mm_mul_ps(x, x);
+
+        __m128 s = _mm_set1_ps(SIN_POLY[0]);
+        __m128 c = _mm_set1_ps(COS_POLY[0]);
+        for (size_t k = 1; k < 3; k++)
+        {
+            s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(SIN_POLY[k]));
+            c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(COS_POLY[k]));
+        }
+        s = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(s, x2), x));
+        c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, _mm_set1_ps(0.5f))),
+                       _mm_mul_ps(_mm_mul_ps(c, x2), x2));
+
+        // Quarter q turns (sin, cos) into (cos, -sin), (-sin, -cos), (-cos, sin)
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quarter, _mm_set1_epi32(1)),
+                                                             _mm_set1_epi32(1)));
+        const __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quarter, _mm_set1_epi32(2)), 30));
+        const __m128 cosineSign = _mm_castsi128_ps(
+            _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quarter, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+        sine = _mm_xor_ps(Select(swap, c, s), sineSign);
+        cosine = _mm_xor_ps(Select(swap, s, c), cosineSign);
+    }
+#endif
+}
+
+ParticleSystem::ParticleSystem(size_t countArg, uint64_t seedArg, unsigned threadsArg)
+    : count(countArg)
+    , seed(seedArg)
+    , threads(std::max(threadsArg, 1u))
+    , px(countArg)
+    , py(countArg)
+    , pz(countArg)
+    , vx(countArg)
+    , vy(countArg)
+    , vz(countArg)
+    , respawn(threads)
+{ }
+
+ParticleSystem::~ParticleSystem() = default;
+
+void ParticleSystem::Update(float dt)
+{
+    core::TraceZone zone("Particle update");
+    // Ranges are multiples of 8 particles, so only the last one has a scalar tail
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(threads, count / MIN_PARTICLES_PER_THREAD));
+    core::ParallelFor(0, workers, 1, [&](size_t w, size_t) {
+        const size_t begin = count * w / workers / 8 * 8;
+        const size_t end = w + 1 == workers ? count : count * (w + 1) / workers / 8 * 8;
+        respawn[w].clear();
+        UpdateRange(begin, end, dt, respawn[w]);
+        Respawn(respawn[w]);
+    });
+    ++step;
+}
+
+void ParticleSystem::UpdateRange(size_t begin, size_t end, float dt, std::vector<uint32_t>& fallen)
+{
+    const float dv = GRAVITY * dt;
+    size_t i = begin;
+
+#if defined(PARTICLES_SIMD) && defined(__AVX__)
+    const __m256 dtv = _mm256_set1_ps(dt);
+    const __m256 dvv = _mm256_set1_ps(dv);
+    const __m256 floor = _mm256_set1_ps(FLOOR_Y);
+    for (; i + 8 <= end; i += 8)
+    {
+        const __m256 sy = _mm256_add_ps(_mm256_loadu_ps(&vy[i]), dvv);
+        _mm256_storeu_ps(&vy[i], sy);
+        const __m256 y = _mm256_add_ps(_mm256_loadu_ps(&py[i]), _mm256_mul_ps(sy, dtv));
+        _mm256_storeu_ps(&py[i], y);
+        _mm256_storeu_ps(&px[i], _mm256_add_ps(_mm256_loadu_ps(&px[i]), _mm256_mul_ps(_mm256_loadu_ps(&vx[i]), dtv)));
+        _mm256_storeu_ps(&pz[i], _mm256_add_ps(_mm256_loadu_ps(&pz[i]), _mm256_mul_ps(_mm256_loadu_ps(&vz[i]), dtv)));
+
+        const int mask = _mm256_movemask_ps(_mm256_cmp_ps(y, floor, _CMP_LT_OQ));
+        for (int lane = 0; mask != 0 && lane < 8; lane++)
+        {
+            if (mask & (1 << lane))
+                fallen.push_back(static_cast<uint32_t>(i) + static_cast<uint32_t>(lane));
+        }
+    }
+#elif defined(PARTICLES_SIMD)
+    const __m128 dtv = _mm_set1_ps(dt);
+    const __m128 dvv = _mm_set1_ps(dv);
+    const __m128 floor = _mm_set1_ps(FLOOR_Y);
+    for (; i + 4 <= end; i += 4)
+    {
+        const __m128 sy = _mm_add_ps(_mm_loadu_ps(&vy[i]), dvv);
+        _mm_storeu_ps(&vy[i], sy);
+        const __m128 y = _mm_add_ps(_mm_loadu_ps(&py[i]), _mm_mul_ps(sy, dtv));
+        _mm_storeu_ps(&py[i], y);
+        _mm_storeu_ps(&px[i], _mm_add_ps(_mm_loadu_ps(&px[i]), _mm_mul_ps(_mm_loadu_ps(&vx[i]), dtv)));
+        _mm_storeu_ps(&pz[i], _mm_add_ps(_mm_loadu_ps(&pz[i]), _mm_mul_ps(_mm_loadu_ps(&vz[i]), dtv)));
+
+        const int mask = _mm_movemask_ps(_mm_cmplt_ps(y, floor));
+        for (int lane = 0; mask != 0 && lane < 4; lane++)
+        {
+            if (mask & (1 << lane))
+                fallen.push_back(static_cast<uint32_t>(i) + static_cast<uint32_t>(lane));
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        vy[i] += dv;
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        pz[i] += vz[i] * dt;
+        if (py[i] < FLOOR_Y)
+            fallen.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+// Box-Muller transform on blocks of fallen particles, 4 at a time with SSE2
+void ParticleSystem::Respawn(const std::vector<uint32_t>& fallen)
+{
+    const uint64_t key = Mix(seed);
+    float u[4][SAMPLE_BLOCK];
+    float normal[3][SAMPLE_BLOCK];
+    for (size_t first = 0; first < fallen.size(); first += SAMPLE_BLOCK)
+    {
+        const size_t n = std::min(SAMPLE_BLOCK, fallen.size() - first);
+        for (size_t j = 0; j < n; j++)
+        {
+            // Words 2c and 2c + 1 of the SplitMix64 sequence started from the seed
+            const uint64_t counter = (step * count + fallen[first + j]) * 2;
+            const uint64_t a = Mix(key + (counter + 1) * GOLDEN_GAMMA);
+            const uint64_t b = Mix(key + (counter + 2) * GOLDEN_GAMMA);
+            u[0][j] = Uniform(static_cast<uint32_t>(a));
+            u[1][j] = Uniform(static_cast<uint32_t>(a >> 32));
+            u[2][j] = Uniform(static_cast<uint32_t>(b));
+            u[3][j] = Uniform(static_cast<uint32_t>(b >> 32));
+        }
+#ifdef PARTICLES_SIMD
+        // The last group of 4 is padded with valid samples
+        for (size_t j = n; j % 4 != 0; j++)
+        {
+            u[0][j] = u[1][j] = u[2][j] = u[3][j] = 0.5f;
+        }
+        const __m128 minusTwo = _mm_set1_ps(-2.0f);
+        for (size_t j = 0; j < n; j += 4)
+        {
+            const __m128 r0 = _mm_sqrt_ps(_mm_mul_ps(minusTwo, Log(_mm_loadu_ps(&u[0][j]))));
+            const __m128 r1 = _mm_sqrt_ps(_mm_mul_ps(minusTwo, Log(_mm_loadu_ps(&u[2][j]))));
+            __m128 sine0, cosine0, sine1, cosine1;
+            SinCosTurns(_mm_loadu_ps(&u[1][j]), sine0, cosine0);
+            SinCosTurns(_mm_loadu_ps(&u[3][j]), sine1, cosine1);
+            _mm_storeu_ps(&normal[0][j], _mm_mul_ps(r0, cosine0));
+            _mm_storeu_ps(&normal[1][j], _mm_mul_ps(r0, sine0));
+            _mm_storeu_ps(&normal[2][j], _mm_mul_ps(r1, cosine1));
+        }
+#else
+        for (size_t j = 0; j < n; j++)
+        {
+            const float r0 = sqrtf(-2 * logf(u[0][j]));
+            const float r1 = sqrtf(-2 * logf(u[2][j]));
+            normal[0][j] = r0 * cosf(TWO_PI * u[1][j]);
+            normal[1][j] = r0 * sinf(TWO_PI * u[1][j]);
+            normal[2][j] = r1 * cosf(TWO_PI * u[3][j]);
+        }
+#endif
+        for (size_t j = 0; j < n; j++)
+        {
+            const uint32_t i = fallen[first + j];
+            px[i] = 0;
+            py[i] = SPAWN_Y;
+            pz[i] = 0;
+            vx[i] = 3.0f + 0.5f * normal[0][j];
+            vy[i] = 15.0f + 1.0f * normal[1][j];
+            vz[i] = 3.0f + 0.5f * normal[2][j];
+        }
+    }
+}
+
+void ParticleSystem::PackPositions(float* out) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[3 * i] = px[i];
+        out[3 * i + 1] = py[i];
+        out[3 * i + 2] = pz[i];
+    }
+}
+
+size_t ParticleSystem::MemoryBytes() const
+{
+    size_t bytes = 0;
+    for (const auto* v : {&px, &py, &pz, &vx, &vy, &vz})
+    {
+        bytes += v->capacity() * sizeof(float);
+    }
+    for (const auto& list : respawn)
+    {
+        bytes += list.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+uint64_t ParticleSystem::Checksum() const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const auto* v : {&px, &py, &pz, &vx, &vy, &vz})
+    {
+        for (float value : *v)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
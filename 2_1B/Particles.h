@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Fountain particles stored as separate coordinate arrays, so that the
+// update works on 8 (AVX) or 4 (SSE) particles at a time.
+// Random speeds of respawned particles depend only on the seed, the update
+// number and the particle index, so results are the same for any thread count.
+class ParticleSystem {
+    size_t count;
+    uint64_t seed;
+    unsigned threads;
+    uint64_t step = 0;
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    // Particles that fell below the floor during the last update, per worker
+    std::vector<std::vector<uint32_t>> respawn;
+
+    void UpdateRange(size_t begin, size_t end, float dt, std::vector<uint32_t>& fallen);
+    void Respawn(const std::vector<uint32_t>& fallen);
+public:
+    ParticleSystem(size_t count, uint64_t seed, unsigned threads);
+    ~ParticleSystem();
+
+    size_t Count() const
+    {
+        return count;
+    }
+
+    // Applies gravity, moves the particles and sends the ones below y = -1
+    // back to the fountain with a random speed
+    void Update(float dt);
+
+    // Interleaved x, y, z positions for the vertex buffer, 3 * Count() floats
+    void PackPositions(float* out) const;
+
+    // Indices of particles respawned by the last update, one list per worker
+    const std::vector<std::vector<uint32_t>>& Respawned() const
+    {
+        return respawn;
+    }
+
+    // Bytes held by the particle state and the respawn lists
+    size_t MemoryBytes() const;
+
+    // FNV-1a hash of the bit patterns of all positions and speeds
+    uint64_t Checksum() const;
+};
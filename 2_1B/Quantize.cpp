@@ -0,0 +1,106 @@
+#include "Quantize.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define QUANTIZE_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+    // Keeps the inverse scale finite for a box of equal points
+    const float MIN_EXTENT = 1e-6f;
+}
+
+PositionBox BoundingBox(const float* positions, size_t count)
+{
+    float lower[3] = {0, 0, 0}, upper[3] = {0, 0, 0};
+    if (count > 0)
+    {
+        std::copy_n(positions, 3, lower);
+        std::copy_n(positions, 3, upper);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            const float v = positions[3 * i + c];
+            lower[c] = v < lower[c] ? v : lower[c];
+            upper[c] = v > upper[c] ? v : upper[c];
+        }
+    }
+
+    PositionBox box;
+    for (int c = 0; c < 3; c++)
+    {
+        box.offset[c] = lower[c];
+        box.scale[c] = std::max(upper[c] - lower[c], MIN_EXTENT);
+    }
+    return box;
+}
+
+PositionBox UnionBox(const PositionBox& a, const PositionBox& b)
+{
+    PositionBox box;
+    for (int c = 0; c < 3; c++)
+    {
+        box.offset[c] = std::min(a.offset[c], b.offset[c]);
+        box.scale[c] = std::max(a.offset[c] + a.scale[c], b.offset[c] + b.scale[c]) - box.offset[c];
+    }
+    return box;
+}
+
+void QuantizePositions(const float* positions, size_t count, const PositionBox& box, uint16_t* out)
+{
+    float multiplier[3];
+    for (int c = 0; c < 3; c++)
+    {
+        multiplier[c] = QUANTIZED_MAX / box.scale[c];
+    }
+
+    size_t i = 0;
+#ifdef QUANTIZE_SIMD
+    // 4 particles are 12 values, the box components repeat every 3 vectors
+    const __m128 offset[3] = {
+        _mm_setr_ps(box.offset[0], box.offset[1], box.offset[2], box.offset[0]),
+        _mm_setr_ps(box.offset[1], box.offset[2], box.offset[0], box.offset[1]),
+        _mm_setr_ps(box.offset[2], box.offset[0], box.offset[1], box.offset[2]),
+    };
+    const __m128 mul[3] = {
+        _mm_setr_ps(multiplier[0], multiplier[1], multiplier[2], multiplier[0]),
+        _mm_setr_ps(multiplier[1], multiplier[2], multiplier[0], multiplier[1]),
+        _mm_setr_ps(multiplier[2], multiplier[0], multiplier[1], multiplier[2]),
+    };
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 top = _mm_set1_ps(QUANTIZED_MAX);
+    // Signed saturating pack after moving the range to [-32768; 32767]
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i q[3];
+        for (int v = 0; v < 3; v++)
+        {
+            __m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(positions + 3 * i + 4 * v), offset[v]), mul[v]);
+            x = _mm_min_ps(_mm_max_ps(_mm_add_ps(x, half), zero), top);
+            q[v] = _mm_sub_epi32(_mm_cvttps_epi32(x), bias);
+        }
+        const __m128i low = _mm_xor_si128(_mm_packs_epi32(q[0], q[1]), flip);
+        const __m128i high = _mm_xor_si128(_mm_packs_epi32(q[2], q[2]), flip);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 3 * i), low);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 3 * i + 8), high);
+    }
+#endif
+
+    for (size_t k = 3 * i; k < 3 * count; k++)
+    {
+        const int c = static_cast<int>(k % 3);
+        float x = (positions[k] - box.offset[c]) * multiplier[c] + 0.5f;
+        // Same order as the SIMD clamp, NaN ends up as 0
+        x = x > 0 ? x : 0;
+        x = x < QUANTIZED_MAX ? x : QUANTIZED_MAX;
+        out[k] = static_cast<uint16_t>(x);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Positions relative to a box as 16 bit fixed point, decoded by the vertex
+// shader as offset + q / 65535 * scale (normalized unsigned short attribute)
+struct PositionBox{
+    float offset[3];
+    float scale[3];
+};
+
+const uint16_t QUANTIZED_MAX = 65535;
+
+// Box around interleaved x, y, z positions, with at least a tiny extent
+PositionBox BoundingBox(const float* positions, size_t count);
+// Smallest box containing both
+PositionBox UnionBox(const PositionBox& a, const PositionBox& b);
+
+// Quantizes count interleaved x, y, z positions, values outside the box are
+// clamped to it. SSE2 packs 4 particles at a time.
+void QuantizePositions(const float* positions, size_t count, const PositionBox& box, uint16_t* out);
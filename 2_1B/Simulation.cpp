@@ -0,0 +1,202 @@
+#include "Simulation.h"
+
+#include <algorithm>
+
+#include "core/Trace.h"
+
+namespace {
+    // If the simulation falls this many steps behind the clock, it stops
+    // trying to catch up
+    const int MAX_STEPS_BEHIND = 5;
+    // Positions are interpolated and culled through stack buffers of this
+    // many particles
+    const size_t BLOCK = 256;
+
+    // Interpolates and classifies blocks of particles, write(positions, n,
+    // first) stores n interleaved positions from particle index first
+    template <typename Write>
+    VisibleCounts CullInterpolated(const float* a, const float* b, size_t count, float alpha,
+                                   const ViewCulling& view, const Write& write)
+    {
+        float x[BLOCK], y[BLOCK], z[BLOCK];
+        uint8_t visibility[BLOCK];
+        float nearBlock[3 * BLOCK], farBlock[3 * BLOCK];
+        VisibleCounts visible = {0, 0};
+        for (size_t first = 0; first < count; first += BLOCK)
+        {
+            const size_t n = std::min(BLOCK, count - first);
+            const float* pa = a + 3 * first;
+            const float* pb = b + 3 * first;
+            for (size_t i = 0; i < n; i++)
+            {
+                x[i] = pa[3 * i] + (pb[3 * i] - pa[3 * i]) * alpha;
+                y[i] = pa[3 * i + 1] + (pb[3 * i + 1] - pa[3 * i + 1]) * alpha;
+                z[i] = pa[3 * i + 2] + (pb[3 * i + 2] - pa[3 * i + 2]) * alpha;
+            }
+            ClassifyParticles(view, x, y, z, n, visibility);
+
+            size_t nearN = 0, farN = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                float* dst = visibility[i] == VISIBILITY_FAR ? &farBlock[3 * farN++] : &nearBlock[3 * nearN];
+                dst[0] = x[i];
+                dst[1] = y[i];
+                dst[2] = z[i];
+                nearN += visibility[i] == VISIBILITY_NEAR;
+            }
+
+            write(nearBlock, nearN, visible.nearCount);
+            visible.nearCount += nearN;
+            visible.farCount += farN;
+            write(farBlock, farN, count - visible.farCount);
+        }
+        return visible;
+    }
+}
+
+ParticleSimulation::ParticleSimulation(size_t count, uint64_t seed, unsigned threads, float stepArg, bool realtimeArg,
+                                       core::FrameTimings* timingsArg)
+    : particles(count, seed, threads)
+    , step(stepArg)
+    , lastPublished(3 * count)
+    , realtime(realtimeArg)
+    , manualNow(Clock::now())
+    , manualStep(manualNow)
+    , timings(timingsArg)
+{
+    if (timings != nullptr)
+    {
+        stepSection = timings->Section("simulation");
+    }
+    particles.PackPositions(lastPublished.data());
+    lastBox = BoundingBox(lastPublished.data(), count);
+    for (Snapshot& slot : slots)
+    {
+        slot.previous = lastPublished;
+        slot.current = lastPublished;
+        slot.box = lastBox;
+        slot.published = Now();
+    }
+    if (realtime)
+    {
+        thread = std::thread(&ParticleSimulation::Run, this);
+    }
+}
+
+ParticleSimulation::~ParticleSimulation()
+{
+    stop = true;
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+ParticleSimulation::Clock::time_point ParticleSimulation::Now() const
+{
+    return realtime ? Clock::now() : manualNow;
+}
+
+void ParticleSimulation::Advance(float seconds)
+{
+    const auto stepDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(step));
+    manualNow += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(seconds));
+    while (!realtime && manualStep + stepDuration <= manualNow)
+    {
+        manualStep += stepDuration;
+        Step();
+        Publish(manualStep);
+    }
+}
+
+void ParticleSimulation::Step()
+{
+    core::TraceZone zone("Simulation step");
+    if (timings != nullptr)
+    {
+        core::ScopeTimer timer(*timings, stepSection);
+        particles.Update(step);
+    }
+    else
+    {
+        particles.Update(step);
+    }
+}
+
+void ParticleSimulation::Run()
+{
+    core::SetTraceThreadName("Simulation");
+    const auto stepDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(step));
+    auto next = Clock::now();
+    while (!stop)
+    {
+        Step();
+        Publish(Clock::now());
+
+        next += stepDuration;
+        const auto now = Clock::now();
+        if (now > next + MAX_STEPS_BEHIND * stepDuration)
+        {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void ParticleSimulation::Publish(Clock::time_point time)
+{
+    Snapshot& back = slots[backSlot];
+    back.previous.swap(lastPublished);
+    particles.PackPositions(back.current.data());
+
+    // Respawned particles jump to the fountain instead of flying there
+    for (const auto& list : particles.Respawned())
+    {
+        for (uint32_t i : list)
+        {
+            std::copy_n(&back.current[3 * i], 3, &back.previous[3 * i]);
+        }
+    }
+
+    lastPublished = back.current;
+    const PositionBox box = BoundingBox(back.current.data(), particles.Count());
+    back.box = UnionBox(lastBox, box);
+    lastBox = box;
+    back.published = time;
+    backSlot = middleSlot.exchange(backSlot | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+const ParticleSimulation::Snapshot& ParticleSimulation::Front(float& alpha)
+{
+    if (middleSlot.load(std::memory_order_relaxed) & FRESH)
+    {
+        frontSlot = middleSlot.exchange(frontSlot, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    const Snapshot& front = slots[frontSlot];
+    alpha = std::min(1.0f, std::chrono::duration<float>(Now() - front.published).count() / step);
+    return front;
+}
+
+VisibleCounts ParticleSimulation::Interpolate(const ViewCulling& view, float* out)
+{
+    core::TraceZone zone("Interpolate");
+    float alpha;
+    const Snapshot& front = Front(alpha);
+    return CullInterpolated(front.previous.data(), front.current.data(), particles.Count(), alpha, view,
+                            [&](const float* positions, size_t n, size_t first) {
+                                std::copy_n(positions, 3 * n, out + 3 * first);
+                            });
+}
+
+VisibleCounts ParticleSimulation::InterpolateQuantized(const ViewCulling& view, uint16_t* out, PositionBox& box)
+{
+    core::TraceZone zone("Interpolate quantized");
+    float alpha;
+    const Snapshot& front = Front(alpha);
+    box = front.box;
+    return CullInterpolated(front.previous.data(), front.current.data(), particles.Count(), alpha, view,
+                            [&](const float* positions, size_t n, size_t first) {
+                                QuantizePositions(positions, n, box, out + 3 * first);
+                            });
+}
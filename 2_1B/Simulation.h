@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <core/Timing.h>
+
+#include "Culling.h"
+#include "Particles.h"
+#include "Quantize.h"
+
+// Particles written by ParticleSimulation::Interpolate
+struct VisibleCounts{
+    // Drawn as meshes, from the start of the output
+    size_t nearCount;
+    // Drawn as points, at the end of the Count() particle output
+    size_t farCount;
+};
+
+// Runs the particle system on its own thread with a fixed timestep. States
+// are passed to the renderer through a triple buffer, so neither side waits
+// for the other. Without realtime there is no thread and the clock only
+// moves by Advance, for reproducible offline frames.
+class ParticleSimulation {
+    using Clock = std::chrono::steady_clock;
+
+    // Positions before and after one step, both interleaved x, y, z, and a
+    // box around both
+    struct Snapshot{
+        std::vector<float> previous, current;
+        PositionBox box;
+        Clock::time_point published;
+    };
+
+    ParticleSystem particles;
+    const float step;
+
+    Snapshot slots[3];
+    // Slot owned by the simulation thread, the renderer and the one between
+    // them, FRESH marks a state the renderer has not seen yet
+    unsigned backSlot = 0, frontSlot = 1;
+    std::atomic<unsigned> middleSlot{2};
+    static const unsigned FRESH = 4;
+
+    std::vector<float> lastPublished;
+    PositionBox lastBox;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+    const bool realtime;
+    // Clock and last step time when not in realtime
+    Clock::time_point manualNow, manualStep;
+    // Optional, steps are timed as the "simulation" section
+    core::FrameTimings* timings;
+    size_t stepSection = 0;
+
+    Clock::time_point Now() const;
+    void Step();
+    void Run();
+    void Publish(Clock::time_point time);
+    // Latest snapshot and its interpolation factor
+    const Snapshot& Front(float& alpha);
+public:
+    ParticleSimulation(size_t count, uint64_t seed, unsigned threads, float step, bool realtime = true,
+                       core::FrameTimings* timings = nullptr);
+    ~ParticleSimulation();
+
+    ParticleSimulation(const ParticleSimulation&) = delete;
+    ParticleSimulation& operator=(const ParticleSimulation&) = delete;
+
+    size_t Count() const
+    {
+        return particles.Count();
+    }
+
+    // Moves the manual clock and runs the steps that fall before it
+    void Advance(float seconds);
+
+    // Positions one step behind the simulation, interpolated between the two
+    // latest states. Particles outside the view are dropped, near and far
+    // ones are compacted to the two ends of out. Only called from the
+    // rendering thread.
+    VisibleCounts Interpolate(const ViewCulling& view, float* out);
+    // Same positions quantized to box, 3 * Count() values
+    VisibleCounts InterpolateQuantized(const ViewCulling& view, uint16_t* out, PositionBox& box);
+};
@@ -0,0 +1,174 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
+
+namespace {
+    // Fewer particles are not worth a task of their own
+    const size_t MIN_PARTICLES_PER_THREAD = 1 << 14;
+    const size_t MIN_TABLE_SIZE = 1024;
+    // Cells up to this size are sorted by insertion
+    const uint32_t SMALL_CELL = 16;
+
+    // Calls func(w, begin, end) for `workers` consecutive ranges of [0; n)
+    template <typename F>
+    void ForEachRange(size_t n, size_t workers, const F& func)
+    {
+        core::ParallelFor(0, workers, 1, [&](size_t w, size_t) {
+            func(w, n * w / workers, n * (w + 1) / workers);
+        });
+    }
+}
+
+SpatialGrid::SpatialGrid(float cellSizeArg, unsigned threadsArg)
+    : inverseCell(1 / cellSizeArg)
+    , threads(std::max(threadsArg, 1u))
+{ }
+
+SpatialGrid::~SpatialGrid() = default;
+
+void SpatialGrid::Build(const float* x, const float* y, const float* z, size_t countArg)
+{
+    core::TraceZone zone("Grid build");
+    count = countArg;
+    size_t tableSize = MIN_TABLE_SIZE;
+    while (tableSize < count)
+    {
+        tableSize *= 2;
+    }
+    if (tableSize != static_cast<size_t>(tableMask) + 1 || !cellCount)
+    {
+        cellCount.reset(new std::atomic<uint32_t>[tableSize]);
+        cellStart.resize(tableSize + 1);
+        tableMask = static_cast<uint32_t>(tableSize - 1);
+    }
+    cellOf.resize(count);
+    rank.resize(count);
+    order.resize(count);
+    sx.resize(count);
+    sy.resize(count);
+    sz.resize(count);
+
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(threads, count / MIN_PARTICLES_PER_THREAD));
+
+    // Counting, the previous count of the cell is the rank of the particle in it
+    ForEachRange(tableSize, workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t h = begin; h < end; h++)
+        {
+            cellCount[h].store(0, std::memory_order_relaxed);
+        }
+    });
+    ForEachRange(count, workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const uint32_t h = (RowHash(Coordinate(y[i]), Coordinate(z[i])) + static_cast<uint32_t>(Coordinate(x[i]))) & tableMask;
+            cellOf[i] = h;
+            rank[i] = cellCount[h].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    // Exclusive prefix sum, block sums first
+    std::vector<uint32_t> blockSum(workers + 1, 0);
+    ForEachRange(tableSize, workers, [&](size_t w, size_t begin, size_t end) {
+        uint32_t sum = 0;
+        for (size_t h = begin; h < end; h++)
+        {
+            sum += cellCount[h].load(std::memory_order_relaxed);
+        }
+        blockSum[w + 1] = sum;
+    });
+    for (size_t w = 1; w <= workers; w++)
+    {
+        blockSum[w] += blockSum[w - 1];
+    }
+    ForEachRange(tableSize, workers, [&](size_t w, size_t begin, size_t end) {
+        uint32_t sum = blockSum[w];
+        for (size_t h = begin; h < end; h++)
+        {
+            cellStart[h] = sum;
+            sum += cellCount[h].load(std::memory_order_relaxed);
+        }
+    });
+    cellStart[tableSize] = static_cast<uint32_t>(count);
+
+    ForEachRange(count, workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            order[cellStart[cellOf[i]] + rank[i]] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // Ranks depend on thread timing, sorting each cell makes the order stable
+    ForEachRange(tableSize, workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t h = begin; h < end; h++)
+        {
+            uint32_t* first = &order[cellStart[h]];
+            const uint32_t n = cellStart[h + 1] - cellStart[h];
+            if (n > SMALL_CELL)
+            {
+                std::sort(first, first + n);
+            }
+            else
+            {
+                for (uint32_t a = 1; a < n; a++)
+                {
+                    const uint32_t value = first[a];
+                    uint32_t b = a;
+                    for (; b > 0 && first[b - 1] > value; b--)
+                    {
+                        first[b] = first[b - 1];
+                    }
+                    first[b] = value;
+                }
+            }
+            for (uint32_t k = cellStart[h]; k < cellStart[h + 1]; k++)
+            {
+                sx[k] = x[order[k]];
+                sy[k] = y[order[k]];
+                sz[k] = z[order[k]];
+            }
+        }
+    });
+}
+
+size_t SpatialGrid::Count() const
+{
+    return count;
+}
+
+const uint32_t* SpatialGrid::Order() const
+{
+    return order.data();
+}
+
+const float* SpatialGrid::SortedX() const
+{
+    return sx.data();
+}
+
+const float* SpatialGrid::SortedY() const
+{
+    return sy.data();
+}
+
+const float* SpatialGrid::SortedZ() const
+{
+    return sz.data();
+}
+
+size_t SpatialGrid::MemoryBytes() const
+{
+    size_t bytes = (static_cast<size_t>(tableMask) + 1) * sizeof(std::atomic<uint32_t>);
+    bytes += cellStart.capacity() * sizeof(uint32_t);
+    for (const auto* v : {&cellOf, &rank, &order})
+    {
+        bytes += v->capacity() * sizeof(uint32_t);
+    }
+    for (const auto* v : {&sx, &sy, &sz})
+    {
+        bytes += v->capacity() * sizeof(float);
+    }
+    return bytes;
+}
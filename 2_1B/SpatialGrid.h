@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Uniform grid hashed into a table of cells, rebuilt from scratch with a
+// parallel counting sort. Particles of one cell are kept sorted by index, so
+// queries visit them in the same order for any thread count.
+class SpatialGrid {
+    float inverseCell;
+    unsigned threads;
+    size_t count = 0;
+    uint32_t tableMask = 0;
+
+    std::unique_ptr<std::atomic<uint32_t>[]> cellCount;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellOf, rank;
+    // Particle indices and positions in cell order
+    std::vector<uint32_t> order;
+    std::vector<float> sx, sy, sz;
+
+    // Rows along x are hashed, cells of a row take consecutive slots, so
+    // that x neighbours share cache lines
+    int32_t Coordinate(float v) const
+    {
+        float c = floorf(v * inverseCell);
+        if (!(c > -COORDINATE_LIMIT))
+            c = -COORDINATE_LIMIT;
+        if (!(c < COORDINATE_LIMIT))
+            c = COORDINATE_LIMIT;
+        return static_cast<int32_t>(c);
+    }
+
+    // Teschner et al., "Optimized Spatial Hashing for Collision Detection of
+    // Deformable Objects", without the x term
+    static uint32_t RowHash(int32_t y, int32_t z)
+    {
+        return (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+    }
+
+    // Cell coordinates are clamped, so that far away and NaN positions still
+    // land in some cell
+    static constexpr float COORDINATE_LIMIT = 1 << 30;
+public:
+    SpatialGrid(float cellSize, unsigned threads);
+    ~SpatialGrid();
+
+    void Build(const float* x, const float* y, const float* z, size_t count);
+
+    // Calls func(index, x, y, z) for every particle in the 27 cells around the
+    // point. These include all particles closer than the cell size, and some
+    // farther ones from hash collisions, so the caller checks the distance.
+    template <typename F>
+    void ForEachCandidate(float x, float y, float z, F&& func) const;
+
+    size_t Count() const;
+    // Particle indices in cell order, Count() elements
+    const uint32_t* Order() const;
+    // Positions in cell order, queries for them touch neighbouring memory
+    const float* SortedX() const;
+    const float* SortedY() const;
+    const float* SortedZ() const;
+
+    size_t MemoryBytes() const;
+};
+
+template <typename F>
+void SpatialGrid::ForEachCandidate(float x, float y, float z, F&& func) const
+{
+    const int32_t cx = Coordinate(x), cy = Coordinate(y), cz = Coordinate(z);
+    // Rows can overlap, a slot within 3 of an earlier row start was visited
+    uint32_t rowFirst[9];
+    int rows = 0;
+    for (int32_t dz = -1; dz <= 1; dz++)
+    {
+        for (int32_t dy = -1; dy <= 1; dy++)
+        {
+            const uint32_t first = (RowHash(cy + dy, cz + dz) + static_cast<uint32_t>(cx) - 1) & tableMask;
+            bool overlap = first + 3 > tableMask + 1;
+            for (int r = 0; r < rows; r++)
+            {
+                overlap = overlap || ((first - rowFirst[r] + 2) & tableMask) < 5;
+            }
+
+            if (!overlap)
+            {
+                // Common case, the whole row is one range
+                for (uint32_t k = cellStart[first]; k < cellStart[first + 3]; k++)
+                {
+                    func(order[k], sx[k], sy[k], sz[k]);
+                }
+            }
+            else
+            {
+                for (uint32_t dx = 0; dx < 3; dx++)
+                {
+                    const uint32_t h = (first + dx) & tableMask;
+                    bool seen = false;
+                    for (int r = 0; r < rows; r++)
+                    {
+                        seen = seen || ((h - rowFirst[r]) & tableMask) < 3;
+                    }
+                    if (seen)
+                        continue;
+
+                    for (uint32_t k = cellStart[h]; k < cellStart[h + 1]; k++)
+                    {
+                        func(order[k], sx[k], sy[k], sz[k]);
+                    }
+                }
+            }
+            rowFirst[rows++] = first;
+        }
+    }
+}
@@ -1,57 +1,122 @@
+#include <stdio.h>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <random>
-#include <chrono>
+#include <string>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <core/ThreadPool.h>
+#include <core/Timing.h>
+#include <core/Trace.h>
 #include <core/Utility.h>
+#include <glwrap/FrameCapture.h>
+#include <glwrap/GpuTimer.h>
+#ifdef GLWRAP_HEADLESS
+#include <glwrap/Headless.h>
+#endif
+#include <glwrap/StreamBuffer.h>
 #include <glwrap/Utility.h>
 
-const int MAX_PARTICLES = 66666;
-const size_t PARTICLE_SIZE = 3;
+#include "Simulation.h"
 
-GLfloat particlePos[PARTICLE_SIZE * MAX_PARTICLES];
-GLfloat particleSpeed[PARTICLE_SIZE * MAX_PARTICLES];
-
-struct Particle {
-    static glm::vec3 fromArray(const GLfloat* arr)
+const size_t DEFAULT_PARTICLES = 66666;
+const size_t PARTICLE_SIZE = 3;
+// Simulation runs at a fixed rate regardless of the frame rate
+const float SIMULATION_STEP = 1 / 120.0f;
+// Particle mesh scale, its bounding sphere radius for culling
+const float PARTICLE_SCALE = 0.1f;
+const float PARTICLE_RADIUS = PARTICLE_SCALE * 1.7321f;
+// Particles smaller than this many pixels are drawn as points
+const float LOD_PIXELS = 4;
+// Simulated time between captured frames
+const float FRAME_TIME = 1 / 60.0f;
+
+static_assert(sizeof(GLfloat) == sizeof(float), "Particle positions are uploaded as floats");
+static_assert(sizeof(GLushort) == sizeof(uint16_t), "Quantized positions are uploaded as unsigned shorts");
+
+const char* USAGE = "Usage: ./2_1b [particle count] [--quantize] [--frames N --output dir|file.raw [--seed S]] "
+                    "[--timings file.csv|file.json]";
+
+int safe_main(int argc, char** argv)
+{
+    size_t particleCount = DEFAULT_PARTICLES;
+    // 16 bit fixed point positions relative to the particle bounding box
+    bool quantize = false;
+    // Headless rendering of a fixed number of frames
+    size_t frames = 0;
+    std::string output;
+    // Per frame timings written on exit
+    std::string timingsPath;
+    uint32_t seed = std::random_device()();
+    for (int i = 1; i < argc; i++)
     {
-        return glm::vec3(arr[0], arr[1], arr[2]);
+        std::string arg = argv[i];
+        if (arg == "--quantize")
+        {
+            quantize = true;
+        }
+        else if ((arg == "--frames" || arg == "--output" || arg == "--seed" || arg == "--timings") && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (arg == "--frames")
+                frames = std::stoull(value);
+            else if (arg == "--output")
+                output = value;
+            else if (arg == "--timings")
+                timingsPath = value;
+            else
+                seed = static_cast<uint32_t>(std::stoul(value));
+        }
+        else if (i == 1)
+        {
+            particleCount = std::stoull(arg);
+        }
+        else
+        {
+            throw GrafikaException(USAGE);
+        }
     }
-
-    static void toArray(GLfloat* arr, const glm::vec3& val)
+    if (particleCount == 0 || particleCount > INT32_MAX || (frames > 0) != !output.empty())
     {
-        arr[0] = val.x;
-        arr[1] = val.y;
-        arr[2] = val.z;
+        throw GrafikaException(USAGE);
     }
 
-    static void update(GLfloat* pos, GLfloat* speed, float dt, std::mt19937& gen) {
-        glm::vec3 p = fromArray(pos);
-        glm::vec3 s = fromArray(speed);
-        s += glm::vec3(0, -10, 0) * dt;
-        p += s * dt;
-        if (p.y < -1.0f) {
-            p = glm::vec3(0.0f, -0.5f, 0.0f);
-            s = glm::vec3(std::normal_distribution(3.0f, 0.5f)(gen),
-                          std::normal_distribution(15.0f,1.0f)(gen),
-                          std::normal_distribution(3.0f, 0.5f)(gen));
-        }
-        toArray(speed, s);
-        toArray(pos, p);
+    std::mt19937 generator(seed);
+    core::FrameTimings timings;
+    const size_t frameSection = timings.Section("frame");
+    const size_t interpolateSection = timings.Section("interpolate");
+    const size_t submitSection = timings.Section("submit");
+    const size_t presentSection = timings.Section("present");
+    const size_t gpuMeshSection = timings.Section("gpu meshes");
+    const size_t gpuPointSection = timings.Section("gpu points");
+    const size_t gpuPlaneSection = timings.Section("gpu plane");
+    const bool headless = frames > 0;
+    GLFWwindow* window = nullptr;
+    int width, height;
+#ifdef GLWRAP_HEADLESS
+    std::unique_ptr<glwrap::HeadlessContext> context;
+#endif
+    if (headless)
+    {
+#ifdef GLWRAP_HEADLESS
+        context = std::make_unique<glwrap::HeadlessContext>();
+        width = context->Width();
+        height = context->Height();
+#else
+        throw GrafikaException("Headless rendering needs EGL");
+#endif
+    }
+    else
+    {
+        window = glwrap::CreateWindow("2.1B");
+        glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
+        glfwGetFramebufferSize(window, &width, &height);
     }
-};
-
-int safe_main(int, char**)
-{
-    std::random_device device;
-    std::mt19937 generator(device());
-    GLFWwindow* window = glwrap::CreateWindow("2.1B");
-
-    glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
@@ -69,10 +134,14 @@ int safe_main(int, char**)
     layout(location = 2) in vec3 vPos;
     uniform mat4 MV;
     uniform mat4 SCALE;
+    // Decoding of quantized positions, 0 and 1 for floats
+    uniform vec3 POS_OFFSET;
+    uniform vec3 POS_SCALE;
     out vec3 fragmentColor;
 
     void main() {
-        gl_Position = MV * (vec4(vPos, 0) + (SCALE * vec4(vPosModelspace , 1)));
+        vec3 pos = POS_OFFSET + vPos * POS_SCALE;
+        gl_Position = MV * (vec4(pos, 0) + (SCALE * vec4(vPosModelspace , 1)));
         fragmentColor = vColor;
     }
     )");
@@ -89,6 +158,34 @@ int safe_main(int, char**)
 
     GLuint programId = glwrap::LoadShaders(vertexShader, fragmentShader);
 
+    const std::string pointVertexShader(R"(
+    #version 330 core
+
+    layout(location = 2) in vec3 vPos;
+    uniform mat4 MV;
+    uniform vec3 POS_OFFSET;
+    uniform vec3 POS_SCALE;
+    // Particle size in pixels at distance 1
+    uniform float POINT_SIZE;
+
+    void main() {
+        gl_Position = MV * vec4(POS_OFFSET + vPos * POS_SCALE, 1);
+        gl_PointSize = max(POINT_SIZE / gl_Position.w, 1.0);
+    }
+    )");
+
+    const std::string pointFragmentShader(R"(
+    #version 330 core
+    out vec3 color;
+
+    void main() {
+        color = vec3(0.5, 0.5, 0.9);
+    }
+    )");
+
+    GLuint pointProgramId = glwrap::LoadShaders(pointVertexShader, pointFragmentShader);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
     const GLfloat gPlane[] = {
         -1, 0, 1,
         1, 0, -1,
@@ -143,8 +240,12 @@ int safe_main(int, char**)
     }
 
 
-    GLuint particlePosBuffer;
-    glGenBuffers(1, &particlePosBuffer);
+    // Offline frames advance the simulation by FRAME_TIME each
+    ParticleSimulation simulation(particleCount, generator(), core::ThreadCount(), SIMULATION_STEP,
+                                  !headless, &timings);
+    // Interpolated positions are written straight into the mapped buffer
+    const size_t componentSize = quantize ? sizeof(GLushort) : sizeof(GLfloat);
+    glwrap::StreamBuffer particlePos(GL_ARRAY_BUFFER, PARTICLE_SIZE * particleCount * componentSize);
 
     GLuint planeVertexBuffer;
     glGenBuffers(1, &planeVertexBuffer);
@@ -176,35 +277,73 @@ int safe_main(int, char**)
 
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4 / (float)3, 0.1f, 100.0f);
     // glm::mat4 projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.0f, 100.0f);
-    glm::mat4 view = glm::lookAt(glm::vec3(30, 20, -20), glm::vec3(0, 10, 0), glm::vec3(0, 1, 0));
+    const glm::vec3 eye(30, 20, -20);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0, 10, 0), glm::vec3(0, 1, 0));
     // glm::mat4 rot = glm::rotate(glm::mat4(1.0f), glm::radians(1.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     GLint mvId = glGetUniformLocation(programId, "MV");
     GLint scaleId = glGetUniformLocation(programId, "SCALE");
-
-    auto timePoint = std::chrono::high_resolution_clock::now();
+    GLint posOffsetId = glGetUniformLocation(programId, "POS_OFFSET");
+    GLint posScaleId = glGetUniformLocation(programId, "POS_SCALE");
+    GLint pointMvId = glGetUniformLocation(pointProgramId, "MV");
+    GLint pointOffsetId = glGetUniformLocation(pointProgramId, "POS_OFFSET");
+    GLint pointScaleId = glGetUniformLocation(pointProgramId, "POS_SCALE");
+    GLint pointSizeId = glGetUniformLocation(pointProgramId, "POINT_SIZE");
+    const PositionBox unitBox = {{0, 0, 0}, {1, 1, 1}};
+
+    // Size in pixels of a particle at distance 1
+    const float pointSize = 2 * PARTICLE_SCALE * projection[1][1] * static_cast<float>(height) / 2;
+
+    glm::mat4 viewProjection = projection * view;
+    const float eyePos[] = {eye.x, eye.y, eye.z};
+    const ViewCulling culling = MakeViewCulling(&viewProjection[0][0], eyePos, PARTICLE_RADIUS,
+                                                pointSize / LOD_PIXELS);
+
+    glwrap::GpuTimer gpuTimer(timings);
+    std::unique_ptr<glwrap::FrameCapture> capture;
+    if (headless)
+    {
+        capture = std::make_unique<glwrap::FrameCapture>(width, height, output);
+        printf("Sēkla: %u\n", seed);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    size_t frame = 0;
+    bool running = true;
 
     do {
-        auto tmpTimePoint = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<float> elapsedDuration = tmpTimePoint - timePoint;
-        float elapsed = elapsedDuration.count();
-        timePoint = tmpTimePoint;
+        timings.NextFrame();
+        core::ScopeTimer frameTimer(timings, frameSection);
+        core::TraceZone frameZone("Frame");
+        if (headless)
+        {
+            simulation.Advance(FRAME_TIME);
+        }
 
-        for (int i = 0; i < MAX_PARTICLES; i++)
+        PositionBox box = unitBox;
+        VisibleCounts visible;
+        core::ScopeTimer interpolateTimer(timings, interpolateSection);
+        if (quantize)
+        {
+            visible = simulation.InterpolateQuantized(culling, static_cast<GLushort*>(particlePos.Map()), box);
+        }
+        else
         {
-            Particle::update(&particlePos[3 * i], &particleSpeed[3 * i], elapsed, generator);
+            visible = simulation.Interpolate(culling, static_cast<GLfloat*>(particlePos.Map()));
         }
+        particlePos.Unmap();
+        interpolateTimer.Stop();
 
+        // GL commands only, the GPU time is measured by the queries
+        core::ScopeTimer submitTimer(timings, submitSection);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glUseProgram(programId);
 
-        glBindBuffer(GL_ARRAY_BUFFER, particlePosBuffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(particlePos), particlePos, GL_STREAM_DRAW);
-
         glm::mat4 mv = projection * view;
-        glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(0.1f));
+        glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(PARTICLE_SCALE));
         glUniformMatrix4fv(mvId, 1, GL_FALSE, &mv[0][0]);
         glUniformMatrix4fv(scaleId, 1, GL_FALSE, &scale[0][0]);
+        glUniform3fv(posOffsetId, 1, box.offset);
+        glUniform3fv(posScaleId, 1, box.scale);
 
         glEnableVertexAttribArray(0);
         glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
@@ -215,19 +354,49 @@ int safe_main(int, char**)
         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
         glEnableVertexAttribArray(2);
-        glBindBuffer(GL_ARRAY_BUFFER, particlePosBuffer);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, particlePos.Id());
+        if (quantize)
+        {
+            glVertexAttribPointer(2, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0, particlePos.Offset());
+        }
+        else
+        {
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, particlePos.Offset());
+        }
 
         glVertexAttribDivisor(0, 0);
         glVertexAttribDivisor(1, 0);
         glVertexAttribDivisor(2, 1);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, sizeof(gVertexBufferData) / (3 * sizeof(GLfloat)), MAX_PARTICLES);
+        gpuTimer.Begin(gpuMeshSection);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, sizeof(gVertexBufferData) / (3 * sizeof(GLfloat)),
+                              static_cast<GLsizei>(visible.nearCount));
+        gpuTimer.End();
+
+        // Far particles, stored at the end of the buffer
+        glUseProgram(pointProgramId);
+        glUniformMatrix4fv(pointMvId, 1, GL_FALSE, &mv[0][0]);
+        glUniform3fv(pointOffsetId, 1, box.offset);
+        glUniform3fv(pointScaleId, 1, box.scale);
+        glUniform1f(pointSizeId, pointSize);
+        glDisableVertexAttribArray(0);
+        glDisableVertexAttribArray(1);
+        glVertexAttribDivisor(2, 0);
+        gpuTimer.Begin(gpuPointSection);
+        glDrawArrays(GL_POINTS, static_cast<GLint>(particleCount - visible.farCount),
+                     static_cast<GLsizei>(visible.farCount));
+        gpuTimer.End();
+        particlePos.Fence();
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glUseProgram(programId);
 
         // DRAW BLUE PLANE
         mv = projection * view;
         scale = glm::scale(glm::mat4(1.0f), glm::vec3(50, 50, 50));
         glUniformMatrix4fv(mvId, 1, GL_FALSE, &mv[0][0]);
         glUniformMatrix4fv(scaleId, 1, GL_FALSE, &scale[0][0]);
+        glUniform3fv(posOffsetId, 1, unitBox.offset);
+        glUniform3fv(posScaleId, 1, unitBox.scale);
 
         glBindBuffer(GL_ARRAY_BUFFER, planeVertexBuffer);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
@@ -238,20 +407,49 @@ int safe_main(int, char**)
         glBindBuffer(GL_ARRAY_BUFFER, planePosBuffer);
         glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
+        gpuTimer.Begin(gpuPlaneSection);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        gpuTimer.End();
 
         glDisableVertexAttribArray(0);
         glDisableVertexAttribArray(1);
         glDisableVertexAttribArray(2);
+        submitTimer.Stop();
+
+        core::ScopeTimer presentTimer(timings, presentSection);
+        if (headless)
+        {
+            capture->Capture();
+            running = ++frame < frames;
+        }
+        else
+        {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            running = glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS && glfwWindowShouldClose(window) == false;
+        }
+        presentTimer.Stop();
+        gpuTimer.Collect();
+    } while (running);
+
+    if (headless)
+    {
+        capture->Finish();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%zu kadri %.2f s laikā, %.1f kadri/s\n", frames, seconds, static_cast<double>(frames) / seconds);
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
-             glfwWindowShouldClose(window) == false);
+    gpuTimer.Finish();
+    timings.PrintSummary(std::cout);
+    if (!timingsPath.empty())
+    {
+        timings.Write(timingsPath);
+    }
 
     glDeleteBuffers(1, &colorBuffer);
     glDeleteBuffers(1, &vertexBuffer);
     glDeleteVertexArrays(1, &vertexArrayId);
+    glDeleteProgram(pointProgramId);
     glDeleteProgram(programId);
 
     return 0;
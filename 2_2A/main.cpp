@@ -2,8 +2,11 @@
 #include <exception>
 #include <sstream>
 #include <assert.h>
+#include <atomic>
 
 #include <opencv2/opencv.hpp>
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
 #include "core/Utility.h"
 
 
@@ -11,17 +14,20 @@ const double PI  = 3.14159265358979323846264338327950288419716939937510582097494
 
 cv::Mat Dft(const cv::Mat& img, bool inv = false) {
     assert(img.type() == CV_32FC2);
+    core::TraceZone zone(inv ? "Inverse DFT" : "DFT");
     std::cout << "Calculating DFT" << std::endl;
 
     cv::Mat output = cv::Mat(img.rows, img.cols, CV_32FC2);
-    std::vector<double[2]> P(static_cast<size_t>(output.cols));
 
     const double u2PI = (inv ? 2 : -2) * PI;
     double normal = (inv ? output.rows * output.cols : 1);
 
-    for (int k = 0; k < output.rows; k++)
-    {
-        std::cout << "Calculating " << k << " / " << img.rows << "\n";
+    // Output rows are independent
+    std::atomic<int> done(0);
+    core::ParallelFor(0, static_cast<size_t>(output.rows), 1, [&](size_t row, size_t) {
+        core::TraceZone rowZone("DFT row");
+        const int k = static_cast<int>(row);
+        std::vector<double[2]> P(static_cast<size_t>(output.cols));
 
         // Calculating P(k, b)
         for (int b = 0; b < output.cols; b++)
@@ -55,7 +61,8 @@ cv::Mat Dft(const cv::Mat& img, bool inv = false) {
             res[0] = r0 / normal;
             res[1] = r1 / normal;
         }
-    }
+        printf("Calculated %d / %d\n", ++done, img.rows);
+    });
     std::cout << "DFT calculated" << std::endl;
     return output;
 }
@@ -0,0 +1,180 @@
+#include "Antialiasing.h"
+
+#include <math.h>
+
+#include "core/Trace.h"
+#include "Rasterizer.h"
+
+namespace {
+    // Accumulation buffer of a strip is kept below this many cells
+    const ll MAX_STRIP_CELLS = 1 << 22;
+
+    // Adds signed area of an edge piece inside one column. The piece is |w| wide
+    // and goes from height ya to yb, both inside [0; H]. After a prefix sum
+    // down the column every cell holds the share of the pixel below the edge.
+    void AccumulatePiece(float* acc, int stride, double w, double ya, double yb)
+    {
+        const double lo = std::min(ya, yb);
+        const double hi = std::max(ya, yb);
+        const double loFloor = floor(lo);
+        const int loi = static_cast<int>(loFloor);
+        const int hii = static_cast<int>(ceil(hi));
+
+        auto add = [&](int y, double v) { acc[static_cast<ll>(y) * stride] += static_cast<float>(v); };
+
+        if (hii <= loi + 1)
+        {
+            const double mid = 0.5 * (ya + yb) - loFloor;
+            add(loi, w - w * mid);
+            add(loi + 1, w * mid);
+            return;
+        }
+
+        const double s = 1 / (hi - lo);
+        const double loFrac = lo - loFloor;
+        const double a0 = 0.5 * s * (1 - loFrac) * (1 - loFrac);
+        const double hiFrac = hi - hii + 1;
+        const double am = 0.5 * s * hiFrac * hiFrac;
+
+        add(loi, w * a0);
+        if (hii == loi + 2)
+        {
+            add(loi + 1, w * (1 - a0 - am));
+        }
+        else
+        {
+            const double a1 = s * (1.5 - loFrac);
+            add(loi + 1, w * (a1 - a0));
+            for (int y = loi + 2; y < hii - 1; y++)
+            {
+                add(y, w * s);
+            }
+            const double a2 = a1 + (hii - loi - 3) * s;
+            add(hii - 1, w * (1 - a2 - am));
+        }
+        add(hii, w * am);
+    }
+
+    // Splits the piece of an edge inside one column by the top and bottom of
+    // the image. Above the image it covers the whole column, below - nothing.
+    // The sign of w is the winding direction of the edge.
+    void AccumulateColumn(float* acc, int stride, int H, double w, double ya, double yb)
+    {
+        if (ya > yb)
+        {
+            std::swap(ya, yb);
+        }
+        if (ya >= H)
+            return;
+
+        if (ya < 0)
+        {
+            const double t = std::min(1.0, -ya / (yb - ya));
+            acc[0] += static_cast<float>(w * t);
+            if (t >= 1)
+                return;
+            w -= w * t;
+            ya = 0;
+        }
+        if (yb > H)
+        {
+            w *= (H - ya) / (yb - ya);
+            yb = H;
+        }
+        AccumulatePiece(acc, stride, w, ya, yb);
+    }
+
+    // dir is +1 for edges going right and -1 for edges going left
+    void AccumulateEdge(const Segment& e, double dir, int x0, int x1, int H, float* acc, int stride)
+    {
+        // Shift so that pixel x covers [x; x + 1)
+        const double ax = e.a.x + 0.5, ay = e.a.y + 0.5;
+        const double bx = e.b.x + 0.5, by = e.b.y + 0.5;
+        const double slope = (by - ay) / (bx - ax);
+
+        const double cx0 = std::max(ax, static_cast<double>(x0));
+        const double cx1 = std::min(bx, static_cast<double>(x1));
+
+        for (int x = static_cast<int>(floor(cx0)); x < cx1; x++)
+        {
+            const double l = std::max(cx0, static_cast<double>(x));
+            const double r = std::min(cx1, static_cast<double>(x + 1));
+            AccumulateColumn(acc + (x - x0), stride, H,
+                             dir * (r - l), ay + slope * (l - ax), ay + slope * (r - ax));
+        }
+    }
+}
+
+void DrawSceneAntialiased(const Scene& scene, cv::Mat& mat, unsigned threads)
+{
+    core::TraceZone zone("Draw scene antialiased");
+    assert(mat.type() == CV_8U);
+
+    const int H = mat.rows;
+    const int W = mat.cols;
+    const std::vector<Extent> extent = PolygonExtents(scene);
+    const int maxWidth = static_cast<int>(std::max<ll>(16, MAX_STRIP_CELLS / (H + 2)));
+
+    ForEachStrip(W, threads, maxWidth, [&](int x0, int x1) {
+        const int stride = x1 - x0;
+        // Rows 0..H+1, edge pieces ending on the last image row spill two cells down
+        std::vector<float> acc(static_cast<size_t>(H + 2) * stride, 0.0f);
+        std::vector<float> sum(static_cast<size_t>(stride));
+
+        for (size_t p = 0; p < scene.PolygonCount(); p++)
+        {
+            // Shifted polygon reaches columns minX..maxX and rows minY..maxY
+            const Extent& ex = extent[p];
+            if (ex.minX >= x1 || ex.maxX < x0 || ex.minY >= H)
+                continue;
+
+            // Signed area needs the edge direction, so edges are binned here
+            // and not with BinEdges. Shifted edges reach columns a.x..b.x.
+            const Point* pts = scene.points + scene.PolygonBegin(p);
+            const size_t n = scene.PolygonEnd(p) - scene.PolygonBegin(p);
+            for (size_t i = 0; i < n; i++)
+            {
+                const Point& from = pts[i == 0 ? n - 1 : i - 1];
+                const Point& to = pts[i];
+                if (from.x == to.x)
+                    continue;
+                Segment e(from, to);
+                if (e.a.x < x1 && e.b.x >= x0)
+                {
+                    AccumulateEdge(e, from.x < to.x ? 1 : -1, x0, x1, H, acc.data(), stride);
+                }
+            }
+
+            // Prefix sum down the columns, row by row so that it runs along
+            // contiguous spans. The buffer is cleared behind for the next polygon.
+            const int c0 = std::max(ex.minX, x0) - x0;
+            const int c1 = std::min(ex.maxX + 1, x1) - x0;
+            const int r0 = std::max(ex.minY, 0);
+            // Pieces above the image land in row 0, so it is always visited
+            const int r1 = std::max(std::min(ex.maxY, H - 1) + 2, r0);
+            std::fill(sum.begin() + c0, sum.begin() + c1, 0.0f);
+            for (int y = r0; y <= r1; y++)
+            {
+                float* row = acc.data() + static_cast<size_t>(y) * stride;
+                for (int c = c0; c < c1; c++)
+                {
+                    sum[c] += row[c];
+                    row[c] = 0;
+                }
+                if (y >= H)
+                    continue;
+
+                unsigned char* dst = mat.ptr<unsigned char>(y) + x0;
+                for (int c = c0; c < c1; c++)
+                {
+                    // Even-odd rule: winding folded to [0; 1] as a triangle wave of period 2
+                    float v = std::fabs(sum[c]);
+                    v -= 2.0f * static_cast<float>(static_cast<int>(0.5f * v));
+                    v = std::min(v, 2.0f - v);
+                    unsigned char cov = static_cast<unsigned char>(v * 255.0f + 0.5f);
+                    dst[c] = std::max(dst[c], cov);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "Polygon.h"
+
+// Fills the scene in one pass writing the exact share of every pixel covered
+// by each polygon, scaled to [0; 255]. Signed area is accumulated per pixel
+// and folded by the even-odd rule, which is exact unless the polygon crosses
+// itself inside the pixel. Overlapping polygons keep the larger coverage.
+// Pixel (x, y) is the unit square centered at (x, y).
+void DrawSceneAntialiased(const Scene& scene, cv::Mat& mat, unsigned threads);
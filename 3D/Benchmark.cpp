@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include <opencv2/opencv.hpp>
+#include "core/ThreadPool.h"
+#include "core/Utility.h"
+#include "Antialiasing.h"
+#include "Generators.h"
+#include "Rasterizer.h"
+#include "SceneFile.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Fast stages are repeated until they took this long in total
+    const double MIN_MEASUREMENT_MS = 200;
+    const int MAX_REPETITIONS = 20;
+
+    struct Options{
+        int size = 2048;
+        // Set by the global --threads option
+        unsigned threads = core::ThreadCount();
+        size_t maxVertices = 0;
+        std::string output;
+        std::string only;
+    };
+
+    struct Result{
+        std::string generator;
+        size_t requested, vertices;
+        double parseText, parseBinary, edgeSetup, fill, scene, antialiased;
+        int filledPixels;
+    };
+
+    // Best time of a few runs in milliseconds
+    template <typename Func>
+    double Measure(Func func)
+    {
+        double best = 0, total = 0;
+        for (int i = 0; i < MAX_REPETITIONS && total < MIN_MEASUREMENT_MS; i++)
+        {
+            auto start = Clock::now();
+            func();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            best = i == 0 ? ms : std::min(best, ms);
+            total += ms;
+        }
+        return best;
+    }
+
+    Result Run(const GeneratorInfo& info, size_t n, const Options& options)
+    {
+        std::mt19937 generator(static_cast<unsigned>(n));
+        std::vector<Point> points = info.generate(n, options.size, generator);
+        const size_t count = points.size();
+        Scene scene = MakeScene(options.size, options.size, std::move(points), {count});
+
+        Result res;
+        res.generator = info.name;
+        res.requested = n;
+        res.vertices = count;
+
+        // Parsing, through files in the temporary directory
+        const auto dir = std::filesystem::temp_directory_path();
+        const std::string textPath = (dir / "3d_bench_scene.txt").string();
+        const std::string binaryPath = (dir / "3d_bench_scene.bin").string();
+        WriteTextScene(scene, textPath);
+        WriteBinaryScene(scene, binaryPath);
+        res.parseText = Measure([&]() { ReadTextScene(textPath, true); });
+        res.parseBinary = Measure([&]() { MapBinaryScene(binaryPath, true); });
+        std::filesystem::remove(textPath);
+        std::filesystem::remove(binaryPath);
+
+        // Edge setup: extents, binning and ordering of the edges for the sweep
+        std::vector<Segment> bin;
+        res.edgeSetup = Measure([&]() {
+            std::vector<Extent> extent = PolygonExtents(scene);
+            BinEdges(scene, 0, 0, options.size, bin);
+            std::sort(bin.begin(), bin.end(), [](const Segment& l, const Segment& r) { return l.a.x < r.a.x; });
+        });
+
+        cv::Mat mat = cv::Mat::zeros(options.size, options.size, CV_8U);
+        res.fill = Measure([&]() {
+            std::vector<Segment> seg = bin;
+            DrawPolygonRegion(seg, mat, cv::Rect(0, 0, mat.cols, mat.rows));
+        });
+        res.filledPixels = cv::countNonZero(mat);
+
+        res.scene = Measure([&]() { DrawScene(scene, mat, options.threads); });
+        res.antialiased = Measure([&]() { DrawSceneAntialiased(scene, mat, options.threads); });
+        return res;
+    }
+
+    void WriteJson(std::ostream& out, const Options& options, const std::vector<Result>& results)
+    {
+        out << "{\n"
+            << "  \"width\": " << options.size << ",\n"
+            << "  \"height\": " << options.size << ",\n"
+            << "  \"threads\": " << options.threads << ",\n"
+            << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+            out << "    {\"generator\": \"" << r.generator << "\""
+                << ", \"requested_vertices\": " << r.requested
+                << ", \"vertices\": " << r.vertices
+                << ", \"parse_text_ms\": " << r.parseText
+                << ", \"parse_binary_ms\": " << r.parseBinary
+                << ", \"edge_setup_ms\": " << r.edgeSetup
+                << ", \"fill_ms\": " << r.fill
+                << ", \"scene_ms\": " << r.scene
+                << ", \"antialiased_ms\": " << r.antialiased
+                << ", \"filled_pixels\": " << r.filledPixels
+                << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n"
+            << "}\n";
+    }
+
+    Options ParseOptions(int argc, char** argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+            {
+                throw GrafikaException("Missing value for " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--size")
+            {
+                options.size = std::atoi(value.c_str());
+            }
+            else if (arg == "--max-vertices")
+            {
+                options.maxVertices = std::stoull(value);
+            }
+            else if (arg == "--output")
+            {
+                options.output = value;
+            }
+            else if (arg == "--generator")
+            {
+                options.only = value;
+            }
+            else
+            {
+                throw GrafikaException("Usage: ./3d_bench [--size S] [--threads T] [--max-vertices N] "
+                                       "[--generator name] [--output file.json]");
+            }
+        }
+        if (options.size <= 0)
+        {
+            throw GrafikaException("Image size must be positive");
+        }
+        return options;
+    }
+}
+
+int safe_main(int argc, char** argv)
+{
+    Options options = ParseOptions(argc, argv);
+
+    std::vector<Result> results;
+    for (const GeneratorInfo& info : Generators())
+    {
+        if (!options.only.empty() && options.only != info.name)
+            continue;
+
+        const size_t limit = options.maxVertices ? options.maxVertices : info.maxVertices;
+        for (size_t n = 10; n <= limit; n *= 10)
+        {
+            results.push_back(Run(info, n, options));
+            const Result& r = results.back();
+            fprintf(stderr, "%-8s %9zu vertices: parse %.2f / %.2f ms, edges %.2f ms, fill %.2f ms, "
+                    "scene %.2f ms, antialiased %.2f ms\n",
+                    r.generator.c_str(), r.vertices, r.parseText, r.parseBinary,
+                    r.edgeSetup, r.fill, r.scene, r.antialiased);
+        }
+    }
+
+    if (options.output.empty())
+    {
+        WriteJson(std::cout, options, results);
+    }
+    else
+    {
+        std::ofstream out(options.output);
+        WriteJson(out, options, results);
+        if (!out)
+        {
+            throw GrafikaException("Failed to write " + options.output);
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    return core::CatchExceptions(safe_main, argc, argv);
+}
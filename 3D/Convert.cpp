@@ -0,0 +1,27 @@
+#include "core/Utility.h"
+#include "SceneFile.h"
+
+int safe_main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        throw GrafikaException("Usage: ./3d_convert <input scene> <output scene>\n"
+                               "Text scenes are written as binary and binary scenes as text");
+    }
+
+    if (IsBinarySceneFile(argv[1]))
+    {
+        WriteTextScene(MapBinaryScene(argv[1]), argv[2]);
+    }
+    else
+    {
+        WriteBinaryScene(ReadTextScene(argv[1]), argv[2]);
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    return core::CatchExceptions(safe_main, argc, argv);
+}
@@ -0,0 +1,129 @@
+#include "Generators.h"
+
+#include <math.h>
+
+namespace {
+    const double PI = acos(-1.0);
+
+    void AddPoint(std::vector<Point>& points, double x, double y)
+    {
+        Point p{static_cast<int>(lround(x)), static_cast<int>(lround(y))};
+        if (points.empty() || points.back().x != p.x || points.back().y != p.y)
+        {
+            points.push_back(p);
+        }
+    }
+
+    std::vector<Point> Close(std::vector<Point> points)
+    {
+        while (points.size() > 1 && points.front().x == points.back().x && points.front().y == points.back().y)
+        {
+            points.pop_back();
+        }
+        return points;
+    }
+}
+
+std::vector<Point> GenerateRandom(size_t n, int S, std::mt19937& gen)
+{
+    std::uniform_real_distribution<> dist(-0.25 * S, 1.25 * S);
+    std::vector<Point> points;
+    points.reserve(n);
+    while (points.size() < n)
+    {
+        AddPoint(points, dist(gen), dist(gen));
+    }
+    return Close(points);
+}
+
+std::vector<Point> GenerateHuge(size_t n, int, std::mt19937& gen)
+{
+    // Differences of coordinates must fit in int
+    std::uniform_real_distribution<> dist(-1e9, 1e9);
+    std::vector<Point> points;
+    points.reserve(n);
+    while (points.size() < n)
+    {
+        AddPoint(points, dist(gen), dist(gen));
+    }
+    return Close(points);
+}
+
+std::vector<Point> GenerateSpiral(size_t n, int S, std::mt19937&)
+{
+    const double TURNS = 20;
+    // Both sides of the band together are about 60 R long, keep vertices 2 apart
+    const double R = std::max(0.45 * S, n / 30.0);
+    const double band = 0.4 * R / TURNS;
+    const size_t half = n / 2;
+
+    std::vector<Point> points;
+    points.reserve(n);
+    for (size_t i = 0; i < half; i++)
+    {
+        double t = static_cast<double>(i) / half;
+        double r = band + (R - band) * t;
+        AddPoint(points, S / 2.0 + r * cos(2 * PI * TURNS * t), S / 2.0 + r * sin(2 * PI * TURNS * t));
+    }
+    for (size_t i = half; i-- > 0;)
+    {
+        double t = static_cast<double>(i) / half;
+        double r = (R - band) * t;
+        AddPoint(points, S / 2.0 + r * cos(2 * PI * TURNS * t), S / 2.0 + r * sin(2 * PI * TURNS * t));
+    }
+    return Close(points);
+}
+
+std::vector<Point> GenerateStar(size_t n, int S, std::mt19937&)
+{
+    const size_t spikes = std::max<size_t>(n / 2, 2);
+    // Inner circle is about n long, so inner vertices are 2 apart
+    const double outer = std::max(0.45 * S, n / 3.0);
+    const double inner = outer / 2;
+
+    std::vector<Point> points;
+    points.reserve(2 * spikes);
+    for (size_t i = 0; i < spikes; i++)
+    {
+        double a = 2 * PI * i / spikes;
+        double b = 2 * PI * (i + 0.5) / spikes;
+        AddPoint(points, S / 2.0 + outer * cos(a), S / 2.0 + outer * sin(a));
+        AddPoint(points, S / 2.0 + inner * cos(b), S / 2.0 + inner * sin(b));
+    }
+    return Close(points);
+}
+
+std::vector<Point> GenerateComb(size_t n, int S, std::mt19937&)
+{
+    const long long teeth = std::max<long long>(static_cast<long long>(n / 4), 1);
+    // Teeth are 2 wide with a gap of 2, centered on the image
+    const long long left = S / 2 - 2 * teeth;
+    const int spine = S * 7 / 8;
+    const int tip = S / 8;
+
+    std::vector<Point> points;
+    points.reserve(n + 2);
+    AddPoint(points, static_cast<double>(left), S);
+    for (long long i = 0; i < teeth; i++)
+    {
+        const double x = static_cast<double>(left + 4 * i);
+        AddPoint(points, x, tip);
+        AddPoint(points, x + 2, tip);
+        AddPoint(points, x + 2, spine);
+        AddPoint(points, x + 4, spine);
+    }
+    AddPoint(points, static_cast<double>(left + 4 * teeth), S);
+    return Close(points);
+}
+
+const std::vector<GeneratorInfo>& Generators()
+{
+    static const std::vector<GeneratorInfo> generators = {
+        {"random", GenerateRandom, 10000},
+        {"huge", GenerateHuge, 10000},
+        {"spiral", GenerateSpiral, 10000000},
+        {"star", GenerateStar, 10000000},
+        {"comb", GenerateComb, 10000000},
+    };
+    return generators;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Polygon.h"
+
+// Stress polygons for benchmarking. Every generator returns a single polygon
+// of about n vertices for an S x S image, consecutive duplicates are removed.
+// Shapes grow with n so that vertices stay apart on the integer grid, big
+// ones reach far outside the image.
+using PolygonGenerator = std::vector<Point>(*)(size_t n, int S, std::mt19937& gen);
+
+struct GeneratorInfo{
+    std::string name;
+    PolygonGenerator generate;
+    // Default upper bound of vertex counts, edges of the shape cross so many
+    // columns that larger polygons take minutes to fill
+    size_t maxVertices;
+};
+
+// Random vertices around the image, crosses itself everywhere
+std::vector<Point> GenerateRandom(size_t n, int S, std::mt19937& gen);
+
+// Random vertices up to 10^9 away, nearly every edge crosses the image
+std::vector<Point> GenerateHuge(size_t n, int S, std::mt19937& gen);
+
+// Band winding around the image center
+std::vector<Point> GenerateSpiral(size_t n, int S, std::mt19937& gen);
+
+// Star with n / 2 spikes
+std::vector<Point> GenerateStar(size_t n, int S, std::mt19937& gen);
+
+// Comb with n / 4 thin teeth
+std::vector<Point> GenerateComb(size_t n, int S, std::mt19937& gen);
+
+const std::vector<GeneratorInfo>& Generators();
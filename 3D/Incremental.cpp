@@ -0,0 +1,133 @@
+#include "Incremental.h"
+
+#include "core/Trace.h"
+
+namespace {
+    bool operator==(const Point& l, const Point& r)
+    {
+        return l.x == r.x && l.y == r.y;
+    }
+
+    // Pixels of the image whose fill depends on the edge
+    cv::Rect EdgeBounds(const Segment& e, int H, int W)
+    {
+        const ll x0 = std::max<ll>(e.a.x, 0);
+        const ll x1 = std::min<ll>(static_cast<ll>(e.b.x) + 1, W);
+        const ll y0 = std::max<ll>(std::min(e.a.y, e.b.y), 0);
+        const ll y1 = std::min<ll>(static_cast<ll>(std::max(e.a.y, e.b.y)) + 1, H);
+        if (x0 >= x1 || y0 >= y1)
+        {
+            return cv::Rect();
+        }
+        return cv::Rect(static_cast<int>(x0), static_cast<int>(y0),
+                        static_cast<int>(x1 - x0), static_cast<int>(y1 - y0));
+    }
+}
+
+IncrementalRasterizer::IncrementalRasterizer(const Scene& scene, unsigned threadsArg)
+    : points(scene.points, scene.points + scene.pointCount)
+    , polygonEnd(scene.polygonEnd, scene.polygonEnd + scene.polygonCount)
+    , extent(PolygonExtents(scene))
+    , image(cv::Mat::zeros(scene.H, scene.W, CV_8U))
+    , threads(threadsArg)
+{
+    edges.reserve(points.size());
+    for (size_t p = 0; p < scene.PolygonCount(); p++)
+    {
+        for (size_t i = scene.PolygonBegin(p); i < scene.PolygonEnd(p); i++)
+        {
+            edges.emplace_back(points[i == scene.PolygonBegin(p) ? scene.PolygonEnd(p) - 1 : i - 1], points[i]);
+        }
+    }
+
+    Redraw(cv::Rect(0, 0, image.cols, image.rows));
+}
+
+IncrementalRasterizer::~IncrementalRasterizer() = default;
+
+cv::Rect IncrementalRasterizer::MoveVertices(const std::vector<std::pair<size_t, Point>>& moves)
+{
+    cv::Rect dirty;
+    std::vector<size_t> moved;
+
+    for (const auto& move : moves)
+    {
+        const size_t i = move.first;
+        assert(i < points.size());
+
+        const size_t p = static_cast<size_t>(std::upper_bound(polygonEnd.begin(), polygonEnd.end(), i) - polygonEnd.begin());
+        const size_t begin = p == 0 ? 0 : polygonEnd[p - 1];
+        const size_t end = polygonEnd[p];
+        const size_t prev = i == begin ? end - 1 : i - 1;
+        const size_t next = i + 1 == end ? begin : i + 1;
+
+        if (move.second == points[prev] || move.second == points[next])
+            continue;
+
+        // Fill changes only where the old or the new edges pass
+        dirty |= EdgeBounds(edges[i], image.rows, image.cols);
+        dirty |= EdgeBounds(edges[next], image.rows, image.cols);
+        points[i] = move.second;
+        edges[i] = Segment(points[prev], points[i]);
+        edges[next] = Segment(points[i], points[next]);
+        dirty |= EdgeBounds(edges[i], image.rows, image.cols);
+        dirty |= EdgeBounds(edges[next], image.rows, image.cols);
+        moved.push_back(p);
+    }
+
+    std::sort(moved.begin(), moved.end());
+    moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+    for (size_t p : moved)
+    {
+        Extent& e = extent[p];
+        const size_t begin = p == 0 ? 0 : polygonEnd[p - 1];
+        e = {points[begin].x, points[begin].x, points[begin].y, points[begin].y};
+        for (size_t i = begin; i < polygonEnd[p]; i++)
+        {
+            e.minX = std::min(e.minX, points[i].x);
+            e.maxX = std::max(e.maxX, points[i].x);
+            e.minY = std::min(e.minY, points[i].y);
+            e.maxY = std::max(e.maxY, points[i].y);
+        }
+    }
+
+    if (!dirty.empty())
+    {
+        Redraw(dirty);
+    }
+    return dirty;
+}
+
+cv::Rect IncrementalRasterizer::MoveVertex(size_t i, const Point& position)
+{
+    return MoveVertices({{i, position}});
+}
+
+void IncrementalRasterizer::Redraw(const cv::Rect& region)
+{
+    core::TraceZone zone("Redraw region");
+    image(region).setTo(0);
+
+    ForEachStrip(region.width, threads, region.width, [&](int x0, int x1) {
+        const cv::Rect strip(region.x + x0, region.y, x1 - x0, region.height);
+        std::vector<Segment> bin;
+        for (size_t p = 0; p < polygonEnd.size(); p++)
+        {
+            const Extent& e = extent[p];
+            if (e.minX >= strip.x + strip.width || e.maxX <= strip.x
+                || e.minY >= strip.y + strip.height || e.maxY < strip.y)
+                continue;
+
+            // Edges above or below the region still decide the parity inside it
+            bin.clear();
+            for (size_t i = p == 0 ? 0 : polygonEnd[p - 1]; i < polygonEnd[p]; i++)
+            {
+                if (edges[i].a.x != edges[i].b.x && edges[i].a.x < strip.x + strip.width && edges[i].b.x > strip.x)
+                {
+                    bin.push_back(edges[i]);
+                }
+            }
+            DrawPolygonRegion(bin, image, strip);
+        }
+    });
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "Rasterizer.h"
+
+// Keeps the filled image together with the edges of the scene polygons and
+// after vertex moves refills only the part of the image the moved edges can
+// change. The image is always the same as DrawScene would produce.
+class IncrementalRasterizer {
+    std::vector<Point> points;
+    std::vector<uint64_t> polygonEnd;
+    // edges[i] joins vertex i with the previous vertex of its polygon
+    std::vector<Segment> edges;
+    std::vector<Extent> extent;
+    cv::Mat image;
+    unsigned threads;
+
+    void Redraw(const cv::Rect& region);
+public:
+    IncrementalRasterizer(const Scene& scene, unsigned threads);
+    ~IncrementalRasterizer();
+
+    const cv::Mat& Image() const
+    {
+        return image;
+    }
+
+    size_t VertexCount() const
+    {
+        return points.size();
+    }
+
+    const Point& Vertex(size_t i) const
+    {
+        return points[i];
+    }
+
+    // Moves vertices given by their index in the scene, returns the region of
+    // the image which was refilled (empty if nothing could change). Moves which
+    // would collapse an edge to a point are ignored.
+    cv::Rect MoveVertices(const std::vector<std::pair<size_t, Point>>& moves);
+
+    cv::Rect MoveVertex(size_t i, const Point& position);
+};
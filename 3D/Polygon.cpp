@@ -0,0 +1,37 @@
+#include "Polygon.h"
+
+std::vector<Segment> MakeSegments(const Point* points, size_t n)
+{
+    std::vector<Segment> segments;
+    segments.reserve(n);
+    segments.emplace_back(points[0], points[n - 1]);
+    for (size_t i = 1; i < n; i++)
+    {
+        segments.emplace_back(points[i - 1], points[i]);
+    }
+    return segments;
+}
+
+namespace {
+    struct SceneStorage{
+        std::vector<Point> points;
+        std::vector<uint64_t> polygonEnd;
+    };
+}
+
+Scene MakeScene(int H, int W, std::vector<Point> points, std::vector<uint64_t> polygonEnd)
+{
+    auto storage = std::make_shared<SceneStorage>();
+    storage->points = std::move(points);
+    storage->polygonEnd = std::move(polygonEnd);
+
+    Scene scene;
+    scene.H = H;
+    scene.W = W;
+    scene.points = storage->points.data();
+    scene.polygonEnd = storage->polygonEnd.data();
+    scene.pointCount = storage->points.size();
+    scene.polygonCount = storage->polygonEnd.size();
+    scene.storage = std::move(storage);
+    return scene;
+}
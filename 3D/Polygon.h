@@ -0,0 +1,63 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Point{
+    int x, y;
+};
+
+// Binary scene files store vertices exactly like this
+static_assert(sizeof(Point) == 2 * sizeof(int32_t), "Point must be two packed 32 bit integers");
+
+struct Segment{
+    Point a, b;
+
+    Segment(const Point& ain, const Point& bin)
+        : a(ain)
+        , b(bin)
+    {
+        if (a.x > b.x || (a.x == b.x && a.y > b.y))
+        {
+            std::swap(a, b);
+        }
+        assert(b.x >= a.x && (a.x != b.x || a.y < b.y));
+    }
+};
+
+// Polygons of a scene are stored back to back in one vertex array,
+// polygonEnd[i] is one past the last vertex of the i-th polygon. The arrays
+// live either in a parsed text file or directly in a mapped binary file,
+// storage keeps whichever of them alive.
+struct Scene{
+    int W = 0, H = 0;
+    const Point* points = nullptr;
+    const uint64_t* polygonEnd = nullptr;
+    size_t pointCount = 0;
+    size_t polygonCount = 0;
+    std::shared_ptr<const void> storage;
+
+    size_t PolygonCount() const
+    {
+        return polygonCount;
+    }
+
+    size_t PolygonBegin(size_t i) const
+    {
+        return i == 0 ? 0 : polygonEnd[i - 1];
+    }
+
+    size_t PolygonEnd(size_t i) const
+    {
+        return polygonEnd[i];
+    }
+};
+
+std::vector<Segment> MakeSegments(const Point* points, size_t n);
+
+// Creates a scene which owns the given vertex and polygon arrays
+Scene MakeScene(int H, int W, std::vector<Point> points, std::vector<uint64_t> polygonEnd);
@@ -0,0 +1,166 @@
+#include "Rasterizer.h"
+
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
+
+namespace {
+    // Narrower strips spend more time on edge binning than they win on balance
+    const int MIN_STRIP_WIDTH = 64;
+    // Strips per thread, so that a thread with cheap strips takes more of them
+    const int STRIPS_PER_THREAD = 4;
+
+    bool xcompare(const Segment& a, const Segment& b)
+    {
+        return a.a.x < b.a.x;
+    }
+
+    void DrawLine(cv::Mat& mat, int x, int y1, int y2, int yBegin, int yEnd)
+    {
+        y1 = std::max(y1, yBegin);
+        y2 = std::min(y2, yEnd - 1);
+
+        while (y1 <= y2)
+        {
+            mat.at<unsigned char>(y1, x) = 255;
+            ++y1;
+        }
+    }
+}
+
+void DrawPolygonRegion(std::vector<Segment>& seg, cv::Mat& mat, const cv::Rect& region)
+{
+    if (seg.empty())
+        return;
+
+    std::sort(seg.begin(), seg.end(), xcompare);
+
+    const int x0 = region.x, x1 = region.x + region.width;
+    const int y0 = region.y, y1 = region.y + region.height;
+
+    size_t fidx = 0;
+    int xPos = 0;
+
+    std::vector<HorizontalSegment> iseg;
+
+    xPos = std::max(seg[0].a.x, x0);
+
+    while (xPos < x1 && (fidx == 0 || iseg.size() > 0))
+    {
+        while (fidx < seg.size() && seg[fidx].a.x <= xPos)
+        {
+            if (seg[fidx].a.x != seg[fidx].b.x)
+            {
+                iseg.emplace_back(seg[fidx], xPos);
+            }
+            fidx++;
+        }
+
+        iseg.erase(std::remove_if(iseg.begin(), iseg.end(),
+                                  [=](const HorizontalSegment& hseg)
+                                  { return hseg.endx <= xPos; }),
+                   iseg.end());
+
+        for (auto& t : iseg)
+        {
+            t.advance(xPos);
+        }
+
+        // Bubble sort
+        for (size_t sz = iseg.size(); sz > 0; sz--)
+        {
+            bool cont = false;
+            for (size_t i = 1; i < sz; i++)
+            {
+                if (iseg[i] < iseg[i - 1])
+                {
+                    std::swap(iseg[i], iseg[i - 1]);
+                    cont = true;
+                }
+            }
+            if (cont == false)
+                break;
+        }
+
+        for (size_t i = 1; i < iseg.size(); i+=2)
+        {
+            DrawLine(mat, xPos, iseg[i-1].y.getRoundedPositive(), iseg[i].y.getRoundedPositive(), y0, y1);
+        }
+
+        xPos++;
+    }
+}
+
+void DrawPolygon(std::vector<Segment> seg, cv::Mat& mat)
+{
+    DrawPolygonRegion(seg, mat, cv::Rect(0, 0, mat.cols, mat.rows));
+}
+
+std::vector<Extent> PolygonExtents(const Scene& scene)
+{
+    std::vector<Extent> extent(scene.PolygonCount());
+    for (size_t p = 0; p < scene.PolygonCount(); p++)
+    {
+        Extent& e = extent[p];
+        e = {scene.points[scene.PolygonBegin(p)].x, scene.points[scene.PolygonBegin(p)].x,
+             scene.points[scene.PolygonBegin(p)].y, scene.points[scene.PolygonBegin(p)].y};
+        for (size_t i = scene.PolygonBegin(p); i < scene.PolygonEnd(p); i++)
+        {
+            e.minX = std::min(e.minX, scene.points[i].x);
+            e.maxX = std::max(e.maxX, scene.points[i].x);
+            e.minY = std::min(e.minY, scene.points[i].y);
+            e.maxY = std::max(e.maxY, scene.points[i].y);
+        }
+    }
+    return extent;
+}
+
+void BinEdges(const Scene& scene, size_t p, int x0, int x1, std::vector<Segment>& bin)
+{
+    const Point* pts = scene.points + scene.PolygonBegin(p);
+    const size_t n = scene.PolygonEnd(p) - scene.PolygonBegin(p);
+    bin.clear();
+    for (size_t i = 0; i < n; i++)
+    {
+        Segment e(pts[i], pts[i == 0 ? n - 1 : i - 1]);
+        if (e.a.x != e.b.x && e.a.x < x1 && e.b.x > x0)
+        {
+            bin.push_back(e);
+        }
+    }
+}
+
+void ForEachStrip(int W, unsigned threads, int maxWidth, const std::function<void(int, int)>& func)
+{
+    threads = std::max(threads, 1u);
+    maxWidth = std::max(maxWidth, 1);
+
+    int stripCount = std::max(1, std::min(W / MIN_STRIP_WIDTH,
+                                          STRIPS_PER_THREAD * static_cast<int>(threads)));
+    stripCount = std::max(stripCount, (W + maxWidth - 1) / maxWidth);
+
+    core::ParallelFor(0, static_cast<size_t>(stripCount), 1, [&](size_t s, size_t) {
+        core::TraceZone stripZone("Strip");
+        func(static_cast<int>(static_cast<ll>(W) * static_cast<ll>(s) / stripCount),
+             static_cast<int>(static_cast<ll>(W) * static_cast<ll>(s + 1) / stripCount));
+    });
+}
+
+void DrawScene(const Scene& scene, cv::Mat& mat, unsigned threads)
+{
+    core::TraceZone zone("Draw scene");
+    assert(mat.type() == CV_8U);
+
+    const std::vector<Extent> extent = PolygonExtents(scene);
+
+    ForEachStrip(mat.cols, threads, mat.cols, [&](int x0, int x1) {
+        std::vector<Segment> bin;
+        for (size_t p = 0; p < scene.PolygonCount(); p++)
+        {
+            if (extent[p].minX >= x1 || extent[p].maxX <= x0)
+                continue;
+
+            BinEdges(scene, p, x0, x1, bin);
+            DrawPolygonRegion(bin, mat, cv::Rect(x0, 0, x1 - x0, mat.rows));
+        }
+    });
+}
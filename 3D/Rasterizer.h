@@ -0,0 +1,116 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "Polygon.h"
+
+using ll = long long;
+
+struct FastFloat {
+    static const int FAST_FLOAT_PREC = 16;
+    ll val;
+    explicit FastFloat() {};
+    explicit FastFloat(int ival)
+        : val(static_cast<ll>(ival) << FAST_FLOAT_PREC)
+    {
+    }
+
+    FastFloat operator/(const FastFloat& rhs) const
+    {
+        FastFloat tmp;
+        tmp.val = (val << FAST_FLOAT_PREC) / rhs.val;
+        return tmp;
+    }
+
+    bool operator<(const FastFloat& rhs) const
+    {
+        return val < rhs.val;
+    }
+
+    FastFloat& operator+=(const FastFloat& rhs)
+    {
+        val += rhs.val;
+        return *this;
+    }
+
+    FastFloat operator*(const FastFloat& rhs)
+    {
+        FastFloat tmp;
+        tmp.val = (val * rhs.val) >> FAST_FLOAT_PREC;
+        return tmp;
+    }
+
+    FastFloat operator*(int rhs)
+    {
+        FastFloat tmp;
+        tmp.val = (val * rhs);
+        return tmp;
+    }
+
+    int getRoundedPositive()
+    {
+        return (val + (1 << (FAST_FLOAT_PREC - 1))) >> FAST_FLOAT_PREC;
+    }
+};
+
+struct HorizontalSegment{
+    FastFloat y, a;
+    int x, endx;
+    HorizontalSegment(const Segment& rhs, int xPos)
+    {
+        x = rhs.a.x;
+        y = FastFloat(rhs.a.y);
+        FastFloat dx(rhs.b.x - rhs.a.x);
+        FastFloat dy(rhs.b.y - rhs.a.y);
+        a = dy / dx;
+        endx = rhs.b.x;
+
+        if (x < xPos)
+        {
+            y += a * (xPos - x);
+            x = xPos;
+        }
+    }
+
+    bool operator<(const HorizontalSegment& rhs) const
+    {
+        return y < rhs.y;
+    }
+
+    void advance(int xPos)
+    {
+        if (x >= xPos)
+            return;
+        // x + 1 == xPos
+        y += a;
+        ++x;
+    }
+};
+
+struct Extent{
+    int minX, maxX, minY, maxY;
+};
+
+// Bounding box of every polygon, lets strips skip polygons without visiting their edges
+std::vector<Extent> PolygonExtents(const Scene& scene);
+
+// Collects the non vertical edges of the p-th polygon which have columns inside [x0; x1)
+void BinEdges(const Scene& scene, size_t p, int x0, int x1, std::vector<Segment>& bin);
+
+// Splits columns [0; W) in strips no wider than maxWidth, a few per thread,
+// and calls func(x0, x1) for each of them on the shared thread pool.
+void ForEachStrip(int W, unsigned threads, int maxWidth, const std::function<void(int, int)>& func);
+
+// Fills the part of the polygon given by its edges which is inside region,
+// reorders seg. The pixels do not depend on the region they were drawn with.
+void DrawPolygonRegion(std::vector<Segment>& seg, cv::Mat& mat, const cv::Rect& region);
+
+void DrawPolygon(std::vector<Segment> seg, cv::Mat& mat);
+
+// Splits the image in vertical strips which are filled by worker threads,
+// each strip only looks at the edges crossing it. Because an edge's y at
+// column x is computed exactly in fixed point no matter where the sweep
+// started, the image does not depend on the thread count.
+void DrawScene(const Scene& scene, cv::Mat& mat, unsigned threads);
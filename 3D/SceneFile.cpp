@@ -0,0 +1,264 @@
+#include "SceneFile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <charconv>
+#include <fstream>
+
+#include "core/MappedFile.h"
+#include "core/Trace.h"
+#include "core/Utility.h"
+
+namespace {
+    const char BINARY_MAGIC[4] = {'G', 'P', 'L', 'Y'};
+    const uint32_t BINARY_VERSION = 1;
+
+    struct BinaryHeader{
+        char magic[4];
+        uint32_t version;
+        int32_t H, W;
+        uint64_t polygonCount;
+        uint64_t pointCount;
+    };
+    static_assert(sizeof(BinaryHeader) == 32, "Binary scene header must not have padding");
+
+    // Text is flushed to the stream in pieces of this size
+    const size_t WRITE_CHUNK = 1 << 20;
+
+    class TextCursor{
+        const char* pos;
+        const char* end;
+        const std::string& path;
+    public:
+        TextCursor(const char* begin, size_t size, const std::string& pathArg)
+            : pos(begin)
+            , end(begin + size)
+            , path(pathArg)
+        { }
+
+        // Returns false at the end of file, throws on anything but an integer
+        bool Next(int& value)
+        {
+            while (pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+            {
+                ++pos;
+            }
+            if (pos == end)
+            {
+                return false;
+            }
+            auto res = std::from_chars(pos, end, value);
+            if (res.ec != std::errc())
+            {
+                throw GrafikaException("Nekorekts skaitlis failā: " + path);
+            }
+            pos = res.ptr;
+            return true;
+        }
+    };
+
+    void PrintSummary(const Scene& scene)
+    {
+        printf("Aina ar %zu daudzstūriem, %zu virsotnēm\n", scene.PolygonCount(), scene.pointCount);
+    }
+}
+
+bool IsBinarySceneFile(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (input.is_open() == false)
+    {
+        throw GrafikaException("Couldn't open provided file: " + path);
+    }
+    char magic[sizeof(BINARY_MAGIC)] = {};
+    input.read(magic, sizeof(magic));
+    return input.gcount() == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+Scene ReadTextScene(const std::string& path, bool quiet)
+{
+    core::TraceZone zone("Parse text scene");
+    core::MappedFile file(path);
+    TextCursor cursor(file.Data(), file.Size(), path);
+
+    // First number is the row count of the image, second - column count
+    int H, W;
+    if (!cursor.Next(H) || !cursor.Next(W) || H < 0 || W < 0)
+    {
+        throw GrafikaException("Nekorekts attēla izmērs failā: " + path);
+    }
+
+    // Polygons follow one after another until the end of file
+    std::vector<Point> points;
+    std::vector<uint64_t> polygonEnd;
+    int n;
+    while (cursor.Next(n))
+    {
+        if (n < 3)
+        {
+            throw GrafikaException("Poligonam jāsastāv no vismaz trīs malām");
+        }
+        for (int i = 0; i < n; i++)
+        {
+            Point p;
+            if (!cursor.Next(p.x) || !cursor.Next(p.y))
+            {
+                throw GrafikaException("Failā trūkst daudzstūra virsotņu: " + path);
+            }
+            points.push_back(p);
+        }
+        polygonEnd.push_back(points.size());
+    }
+
+    if (polygonEnd.empty())
+    {
+        throw GrafikaException("Failā nav neviena daudzstūra: " + path);
+    }
+
+    Scene scene = MakeScene(H, W, std::move(points), std::move(polygonEnd));
+    if (!quiet)
+    {
+        PrintSummary(scene);
+    }
+    return scene;
+}
+
+Scene MapBinaryScene(const std::string& path, bool quiet)
+{
+    core::TraceZone zone("Map binary scene");
+    auto file = std::make_shared<core::MappedFile>(path);
+
+    BinaryHeader header;
+    if (file->Size() < sizeof(header))
+    {
+        throw GrafikaException("Bināra daudzstūru faila galvene ir par īsu: " + path);
+    }
+    memcpy(&header, file->Data(), sizeof(header));
+
+    if (memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 || header.version != BINARY_VERSION)
+    {
+        throw GrafikaException("Neatbalstīts bināra daudzstūru faila formāts: " + path);
+    }
+    if (header.H < 0 || header.W < 0 || header.polygonCount == 0)
+    {
+        throw GrafikaException("Nekorekta bināra daudzstūru faila galvene: " + path);
+    }
+
+    const uint64_t endOffset = sizeof(header);
+    const uint64_t pointOffset = endOffset + header.polygonCount * sizeof(uint64_t);
+    if (header.polygonCount > file->Size() / sizeof(uint64_t)
+        || header.pointCount > file->Size() / sizeof(Point)
+        || pointOffset + header.pointCount * sizeof(Point) != file->Size())
+    {
+        throw GrafikaException("Bināra daudzstūru faila izmērs neatbilst galvenei: " + path);
+    }
+
+    Scene scene;
+    scene.H = header.H;
+    scene.W = header.W;
+    scene.polygonCount = static_cast<size_t>(header.polygonCount);
+    scene.pointCount = static_cast<size_t>(header.pointCount);
+    scene.polygonEnd = reinterpret_cast<const uint64_t*>(file->Data() + endOffset);
+    scene.points = reinterpret_cast<const Point*>(file->Data() + pointOffset);
+    scene.storage = file;
+
+    uint64_t begin = 0;
+    for (size_t i = 0; i < scene.polygonCount; i++)
+    {
+        if (scene.polygonEnd[i] < begin + 3 || scene.polygonEnd[i] > scene.pointCount)
+        {
+            throw GrafikaException("Nekorekts daudzstūra apraksts failā: " + path);
+        }
+        begin = scene.polygonEnd[i];
+    }
+    if (begin != scene.pointCount)
+    {
+        throw GrafikaException("Nekorekts daudzstūra apraksts failā: " + path);
+    }
+
+    if (!quiet)
+    {
+        PrintSummary(scene);
+    }
+    return scene;
+}
+
+Scene ReadScene(const std::string& path)
+{
+    return IsBinarySceneFile(path) ? MapBinaryScene(path) : ReadTextScene(path);
+}
+
+void WriteTextScene(const Scene& scene, const std::string& path)
+{
+    core::TraceZone zone("Write text scene");
+    std::ofstream output(path, std::ios::binary);
+    if (output.is_open() == false)
+    {
+        throw GrafikaException("Couldn't open output file: " + path);
+    }
+
+    // Longest line is two integers, a space and a newline
+    const size_t MAX_LINE = 32;
+    std::vector<char> buffer(WRITE_CHUNK + MAX_LINE);
+    char* pos = buffer.data();
+
+    auto writeLine = [&](int a, const int* b) {
+        pos = std::to_chars(pos, pos + MAX_LINE, a).ptr;
+        if (b != nullptr)
+        {
+            *pos++ = ' ';
+            pos = std::to_chars(pos, pos + MAX_LINE, *b).ptr;
+        }
+        *pos++ = '\n';
+        if (static_cast<size_t>(pos - buffer.data()) >= WRITE_CHUNK)
+        {
+            output.write(buffer.data(), pos - buffer.data());
+            pos = buffer.data();
+        }
+    };
+
+    writeLine(scene.H, &scene.W);
+    for (size_t p = 0; p < scene.PolygonCount(); p++)
+    {
+        writeLine(static_cast<int>(scene.PolygonEnd(p) - scene.PolygonBegin(p)), nullptr);
+        for (size_t i = scene.PolygonBegin(p); i < scene.PolygonEnd(p); i++)
+        {
+            writeLine(scene.points[i].x, &scene.points[i].y);
+        }
+    }
+    output.write(buffer.data(), pos - buffer.data());
+
+    if (!output)
+    {
+        throw GrafikaException("Failed to write file: " + path);
+    }
+}
+
+void WriteBinaryScene(const Scene& scene, const std::string& path)
+{
+    core::TraceZone zone("Write binary scene");
+    std::ofstream output(path, std::ios::binary);
+    if (output.is_open() == false)
+    {
+        throw GrafikaException("Couldn't open output file: " + path);
+    }
+
+    BinaryHeader header;
+    memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.H = scene.H;
+    header.W = scene.W;
+    header.polygonCount = scene.polygonCount;
+    header.pointCount = scene.pointCount;
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(scene.polygonEnd),
+                 static_cast<std::streamsize>(scene.polygonCount * sizeof(uint64_t)));
+    output.write(reinterpret_cast<const char*>(scene.points),
+                 static_cast<std::streamsize>(scene.pointCount * sizeof(Point)));
+
+    if (!output)
+    {
+        throw GrafikaException("Failed to write file: " + path);
+    }
+}
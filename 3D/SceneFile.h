@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "Polygon.h"
+
+// Text scene files follow the format described in README, binary files are
+//   char magic[4] = "GPLY", uint32 version, int32 H, int32 W,
+//   uint64 polygonCount, uint64 pointCount,
+//   uint64 polygonEnd[polygonCount], int32 {x, y}[pointCount]
+// all in little endian, so that a mapped file can be used without copying.
+
+bool IsBinarySceneFile(const std::string& path);
+
+// Parses a memory mapped text file. Prints the polygon and vertex counts
+// unless quiet.
+Scene ReadTextScene(const std::string& path, bool quiet = false);
+
+// Maps a binary file, the returned scene points straight into the mapping
+Scene MapBinaryScene(const std::string& path, bool quiet = false);
+
+// Picks the reader by looking at the start of the file
+Scene ReadScene(const std::string& path);
+
+void WriteTextScene(const Scene& scene, const std::string& path);
+
+void WriteBinaryScene(const Scene& scene, const std::string& path);
@@ -1,238 +1,134 @@
 #include <stdio.h>
 #include <exception>
-#include <sstream>
-#include <fstream>
-#include <assert.h>
-#include <algorithm>
 
 #include <opencv2/opencv.hpp>
+#include "core/ThreadPool.h"
 #include "core/Utility.h"
+#include "Antialiasing.h"
+#include "Incremental.h"
+#include "Rasterizer.h"
+#include "SceneFile.h"
 
-using ll = long long;
+namespace {
+    // Vertices further away from the click (in image pixels) are not picked up
+    const long long PICK_RADIUS = 10;
 
-struct Point{
-    int x, y;
-};
+    struct EditState{
+        IncrementalRasterizer& raster;
+        const std::string& title;
+        long long dragged;
+    };
 
-struct Segment{
-    Point a, b;
-
-    Segment(const Point& ain, const Point& bin)
-        : a(ain)
-        , b(bin)
+    void OnMouse(int event, int x, int y, int flags, void* userdata)
     {
-        if (a.x > b.x || (a.x == b.x && a.y > b.y))
+        EditState& state = *static_cast<EditState*>(userdata);
+
+        if (event == cv::EVENT_LBUTTONDOWN)
         {
-            std::swap(a, b);
+            long long best = PICK_RADIUS * PICK_RADIUS + 1;
+            state.dragged = -1;
+            for (size_t i = 0; i < state.raster.VertexCount(); i++)
+            {
+                long long dx = state.raster.Vertex(i).x - x;
+                long long dy = state.raster.Vertex(i).y - y;
+                if (dx * dx + dy * dy < best)
+                {
+                    best = dx * dx + dy * dy;
+                    state.dragged = static_cast<long long>(i);
+                }
+            }
         }
-        assert(b.x >= a.x && (a.x != b.x || a.y < b.y));
-    }
-};
-
-struct FastFloat {
-    static const int FAST_FLOAT_PREC = 16;
-    ll val;
-    explicit FastFloat() {};
-    explicit FastFloat(int ival)
-        : val(static_cast<ll>(ival) << FAST_FLOAT_PREC)
-    {
-    }
-
-    FastFloat operator/(const FastFloat& rhs) const
-    {
-        FastFloat tmp;
-        tmp.val = (val << FAST_FLOAT_PREC) / rhs.val;
-        return tmp;
-    }
-
-    bool operator<(const FastFloat& rhs) const
-    {
-        return val < rhs.val;
-    }
-
-    FastFloat& operator+=(const FastFloat& rhs)
-    {
-        val += rhs.val;
-        return *this;
-    }
-
-    FastFloat operator*(const FastFloat& rhs)
-    {
-        FastFloat tmp;
-        tmp.val = (val * rhs.val) >> FAST_FLOAT_PREC;
-        return tmp;
-    }
-
-    FastFloat operator*(int rhs)
-    {
-        FastFloat tmp;
-        tmp.val = (val * rhs);
-        return tmp;
-    }
-
-    int getRoundedPositive()
-    {
-        return (val + (1 << (FAST_FLOAT_PREC - 1))) >> FAST_FLOAT_PREC;
-    }
-};
-
-struct HorizontalSegment{
-    FastFloat y, a;
-    int x, endx;
-    HorizontalSegment(Segment& rhs, int xPos)
-    {
-        x = rhs.a.x;
-        y = FastFloat(rhs.a.y);
-        FastFloat dx(rhs.b.x - rhs.a.x);
-        FastFloat dy(rhs.b.y - rhs.a.y);
-        a = dy / dx;
-        endx = rhs.b.x;
-
-        if (x < xPos)
+        else if (event == cv::EVENT_LBUTTONUP)
         {
-            y += a * (xPos - x);
-            x = xPos;
+            state.dragged = -1;
+        }
+        else if (event == cv::EVENT_MOUSEMOVE && (flags & cv::EVENT_FLAG_LBUTTON) && state.dragged >= 0)
+        {
+            cv::Rect dirty = state.raster.MoveVertex(static_cast<size_t>(state.dragged), {x, y});
+            if (!dirty.empty())
+            {
+                std::cout << "Pārzīmēts apgabals " << dirty.x << " " << dirty.y << " "
+                          << dirty.width << "x" << dirty.height << std::endl;
+                cv::imshow(state.title, state.raster.Image());
+            }
         }
     }
 
-    bool operator<(const HorizontalSegment& rhs) const
-    {
-        return y < rhs.y;
-    }
-
-    void advance(int xPos)
-    {
-        if (x >= xPos)
-            return;
-        // x + 1 == xPos
-        y += a;
-        ++x;
-    }
-};
-
-std::vector<Segment> ReadSegments(const std::string& path, int& H, int& W)
-{
-    std::ifstream input(path);
-    if (input.is_open() == false)
-    {
-        throw GrafikaException("Couldn't open provided file: " + path);
-    }
-
-    std::vector<Segment> segments;
-    std::vector<Point> points;
-    int n;
-    input >> W >> H;
-    input >> n;
-    std::cout << "Poligons ar " << n << " virsotnēm" << std::endl;
-    if (n < 3)
-    {
-        throw GrafikaException("Poligonam jāsastāv no vismaz trīs malām");
-    }
-    points.reserve(n); segments.reserve(n);
-    for (int i = 0; i < n; i++)
-    {
-        int x, y;
-        input >> x >> y;
-        points.push_back({x, y});
-    }
-
-    segments.emplace_back(*points.begin(), *points.rbegin());
-    for (int i = 1; i < n; i++)
+    // Shows the scene and lets vertices be dragged with the mouse, only the
+    // part of the image affected by the moved edges is filled again.
+    void EditScene(const Scene& scene, unsigned threads)
     {
-        segments.emplace_back(points[i - 1], points[i]);
-    }
-
-    return segments;
-}
-
-bool xcompare(const Segment& a, const Segment& b)
-{
-    return a.a.x < b.a.x;
-}
+        const std::string title = "Polygon";
+        IncrementalRasterizer raster(scene, threads);
+        EditState state{raster, title, -1};
 
-void DrawLine(cv::Mat& mat, int x, int y1, int y2, int H)
-{
-    y1 = std::max(y1, 0);
-    y2 = std::min(y2, H - 1);
+        cv::namedWindow(title, cv::WINDOW_NORMAL);
+        cv::resizeWindow(title, 1024, 768);
+        cv::setMouseCallback(title, OnMouse, &state);
+        cv::imshow(title, raster.Image());
 
-    while (y1 <= y2)
-    {
-        mat.at<unsigned char>(y1, x) = 255;
-        ++y1;
+        std::cout << "Velciet virsotnes ar peli, Esc - iziet" << std::endl;
+        while (cv::waitKey(20) != 27)
+        {
+            // Mouse events are delivered while waiting for keys
+        }
+        cv::destroyWindow(title);
     }
 }
 
-void DrawPolygon(std::vector<Segment> seg, cv::Mat& mat)
+int safe_main(int argc, char** argv)
 {
-    std::sort(seg.begin(), seg.end(), xcompare);
-
-    int H = mat.rows;
-    int W = mat.cols;
-
-    size_t fidx = 0;
-    int xPos = 0;
-
-    std::vector<HorizontalSegment> iseg;
-
-    xPos = std::max(seg[0].a.x, 0);
-
-    while (xPos < W && (fidx == 0 || iseg.size() > 0))
+    bool antialiased = false;
+    bool edit = false;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; i++)
     {
-        while (fidx < seg.size() && seg[fidx].a.x <= xPos)
+        if (std::string(argv[i]) == "--aa")
         {
-            if (seg[fidx].a.x != seg[fidx].b.x)
-            {
-                iseg.emplace_back(seg[fidx], xPos);
-            }
-            fidx++;
+            antialiased = true;
         }
-
-        iseg.erase(std::remove_if(iseg.begin(), iseg.end(),
-                                  [=](const HorizontalSegment& hseg)
-                                  { return hseg.endx == xPos; }),
-                   iseg.end());
-
-        for (auto& t : iseg)
+        else if (std::string(argv[i]) == "--edit")
         {
-            t.advance(xPos);
+            edit = true;
         }
-
-        // Bubble sort
-        for (size_t sz = iseg.size(); sz > 0; sz--)
+        else
         {
-            bool cont = false;
-            for (size_t i = 1; i < sz; i++)
-            {
-                if (iseg[i] < iseg[i - 1])
-                {
-                    std::swap(iseg[i], iseg[i - 1]);
-                    cont = true;
-                }
-            }
-            if (cont == false)
-                break;
+            args.push_back(argv[i]);
         }
+    }
 
-        for (size_t i = 1; i < iseg.size(); i+=2)
+    if (args.size() != 1 && args.size() != 2)
+    {
+        throw GrafikaException("No input file provided! Usage: ./progr [--aa | --edit] <text file containing description> [thread count]");
+    }
+
+    if (args.size() == 2)
+    {
+        int count = std::atoi(args[1]);
+        if (count <= 0)
         {
-            DrawLine(mat, xPos, iseg[i-1].y.getRoundedPositive(), iseg[i].y.getRoundedPositive(), H);
+            throw GrafikaException("Thread count must be positive");
         }
-
-        xPos++;
+        core::SetThreadCount(static_cast<unsigned>(count));
     }
-}
+    const unsigned threads = core::ThreadCount();
 
-int safe_main(int argc, char** argv)
-{
-    if (argc != 2)
+    Scene scene = ReadScene(args[0]);
+    if (edit)
     {
-        throw GrafikaException("No input file provided! Usage: ./progr <text file containing description>");
+        EditScene(scene, threads);
+        return 0;
     }
 
-    int W, H;
-    std::vector<Segment> seg = ReadSegments(argv[1], W, H);
-    cv::Mat mat = cv::Mat::zeros(H, W, CV_8U);
-    DrawPolygon(seg, mat);
+    cv::Mat mat = cv::Mat::zeros(scene.H, scene.W, CV_8U);
+    if (antialiased)
+    {
+        DrawSceneAntialiased(scene, mat, threads);
+    }
+    else
+    {
+        DrawScene(scene, mat, threads);
+    }
 
     core::ImageWindow window("Polygon", mat);
 
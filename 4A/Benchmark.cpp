@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "core/Utility.h"
+#include "Matrix.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const size_t POINT_COUNT = 1 << 20;
+    const int PRODUCT_COUNT = 1 << 20;
+    const int REPETITIONS = 5;
+
+    // Best time of a few runs in nanoseconds per item
+    template <typename Func>
+    double Measure(size_t items, Func func)
+    {
+        double best = 0;
+        for (int i = 0; i < REPETITIONS; i++)
+        {
+            auto start = Clock::now();
+            func();
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / items;
+            best = i == 0 ? ns : std::min(best, ns);
+        }
+        return best;
+    }
+
+    template <typename T>
+    Mat4<T> RandomMatrix(std::mt19937& gen)
+    {
+        std::uniform_real_distribution<T> dist(-2, 2);
+        Mat4<T> m;
+        for (auto& row : m.val)
+        {
+            for (auto& v : row)
+            {
+                v = dist(gen);
+            }
+        }
+        return m;
+    }
+
+    template <typename T>
+    void Run(const char* type)
+    {
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<T> dist(-10, 10);
+
+        std::vector<Mat4<T>> mats;
+        for (int i = 0; i < 64; i++)
+        {
+            mats.push_back(RandomMatrix<T>(gen));
+        }
+        std::vector<Vec4<T>> points(POINT_COUNT);
+        for (auto& p : points)
+        {
+            p = Vec4<T>::getPos(dist(gen), dist(gen), dist(gen));
+        }
+        const Mat4<T> mat = RandomMatrix<T>(gen);
+
+        // Products are chained through the accumulator so that none of them can be skipped
+        Mat4<T> accGeneric = Mat4<T>::getUnit(), accSimd = Mat4<T>::getUnit();
+        double mulGeneric = Measure(PRODUCT_COUNT, [&]() {
+            accGeneric = Mat4<T>::getUnit();
+            for (int i = 0; i < PRODUCT_COUNT; i++)
+            {
+                accGeneric = Mat4<T>::multiplyGeneric(accGeneric, mats[i & 63]);
+                accGeneric.val[3][3] = 1;
+            }
+        });
+        double mulSimd = Measure(PRODUCT_COUNT, [&]() {
+            accSimd = Mat4<T>::getUnit();
+            for (int i = 0; i < PRODUCT_COUNT; i++)
+            {
+                accSimd = accSimd * mats[i & 63];
+                accSimd.val[3][3] = 1;
+            }
+        });
+
+        // Products of affine transforms, as composed by the 4a program
+        std::vector<Mat4<T>> affine(mats);
+        for (auto& m : affine)
+        {
+            m.val[3][0] = m.val[3][1] = m.val[3][2] = 0;
+            m.val[3][3] = 1;
+        }
+        Mat4<T> accAffine = Mat4<T>::getUnit();
+        double affineGeneric = Measure(PRODUCT_COUNT, [&]() {
+            accAffine = Mat4<T>::getUnit();
+            for (int i = 0; i < PRODUCT_COUNT; i++)
+            {
+                accAffine = Mat4<T>::multiplyGeneric(accAffine, affine[i & 63]);
+            }
+        });
+        double affineSimd = Measure(PRODUCT_COUNT, [&]() {
+            accAffine = Mat4<T>::getUnit();
+            for (int i = 0; i < PRODUCT_COUNT; i++)
+            {
+                accAffine = accAffine * affine[i & 63];
+            }
+        });
+        double affine3x4 = Measure(PRODUCT_COUNT, [&]() {
+            accAffine = Mat4<T>::getUnit();
+            for (int i = 0; i < PRODUCT_COUNT; i++)
+            {
+                accAffine = Mat4<T>::multiplyAffine(accAffine, affine[i & 63]);
+            }
+        });
+
+        // Same 11 factor chain as in 4a, values may only differ in the sign of zeros
+        const Mat4<T> chainGeneric = affine[0] * affine[1] * affine[2] * affine[3] * affine[4] * affine[5]
+                                     * affine[6] * affine[7] * affine[8] * affine[9] * affine[10];
+        const Mat4<T> chainComposed = Compose(affine[0], affine[1], affine[2], affine[3], affine[4], affine[5],
+                                              affine[6], affine[7], affine[8], affine[9], affine[10]);
+        bool affineSame = true;
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                affineSame &= !(chainGeneric.val[i][j] < chainComposed.val[i][j])
+                              && !(chainGeneric.val[i][j] > chainComposed.val[i][j]);
+            }
+        }
+
+        std::vector<Vec4<T>> outGeneric(points.size()), outSingle(points.size()), outBatch;
+        double vecGeneric = Measure(points.size(), [&]() {
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                outGeneric[i] = Mat4<T>::transformGeneric(mat, points[i]);
+            }
+        });
+        double vecSimd = Measure(points.size(), [&]() {
+            for (size_t i = 0; i < points.size(); i++)
+            {
+                outSingle[i] = mat * points[i];
+            }
+        });
+        double vecBatch = Measure(points.size(), [&]() {
+            outBatch = points;
+            TransformPoints(mat, outBatch.data(), outBatch.size());
+        });
+
+        bool same = memcmp(&accGeneric, &accSimd, sizeof(accGeneric)) == 0
+                    && memcmp(outGeneric.data(), outSingle.data(), points.size() * sizeof(Vec4<T>)) == 0
+                    && memcmp(outGeneric.data(), outBatch.data(), points.size() * sizeof(Vec4<T>)) == 0;
+
+        printf("Mat4<%s> x Mat4: generic %6.2f ns, simd %6.2f ns\n", type, mulGeneric, mulSimd);
+        printf("Mat4<%s> x Vec4: generic %6.2f ns, simd %6.2f ns, TransformPoints %6.2f ns (batch includes copy)\n",
+               type, vecGeneric, vecSimd, vecBatch);
+        printf("Mat4<%s> affine products: generic %6.2f ns, simd %6.2f ns, 3x4 %6.2f ns\n",
+               type, affineGeneric, affineSimd, affine3x4);
+        if (!affineSame)
+        {
+            throw GrafikaException(std::string("Affine composition differs from the generic product for ") + type);
+        }
+        if (!same)
+        {
+            throw GrafikaException(std::string("SIMD results differ from the generic template for ") + type);
+        }
+        printf("Mat4<%s> results are bitwise identical\n", type);
+    }
+}
+
+int safe_main(int, char**)
+{
+    // Constant chains are folded by the compiler
+    constexpr Mat4<double> folded = Compose(Mat4<double>::getTranslate(2, 2, 2),
+                                            Mat4<double>::getXYShearing(0.5),
+                                            Mat4<double>::getScale(0.25, 0.5, 2));
+    printf("Compile time composition: translation (%g, %g, %g), x scale %g\n",
+           folded.val[0][3], folded.val[1][3], folded.val[2][3], folded.val[0][0]);
+
+    Run<float>("float");
+    Run<double>("double");
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    return core::CatchExceptions(safe_main, argc, argv);
+}
@@ -0,0 +1,116 @@
+#include "FrameSequence.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "core/FrameOutput.h"
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
+#include "core/Utility.h"
+#include "Wireframe.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Rendered frames waiting for the encoder, per render thread
+    const size_t QUEUE_FRAMES_PER_THREAD = 2;
+    // Frames handed out at a time, per render thread
+    const size_t WINDOW_FRAMES_PER_THREAD = 4;
+}
+
+void RenderFrameSequence(const Mesh& mesh, const FrameSequenceOptions& options)
+{
+    const unsigned threads = std::max(options.threads, 1u);
+    // The next window starts when the last one is rendered, so the raw writer
+    // never holds back more than a window of frames
+    const size_t window = WINDOW_FRAMES_PER_THREAD * threads;
+    core::FrameWriter writer(options.output, window);
+    core::FrameQueue queue(QUEUE_FRAMES_PER_THREAD * threads);
+
+    std::atomic<size_t> nextFrame(0);
+    std::atomic<bool> failed(false);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto fail = [&]() {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = std::current_exception();
+        failed = true;
+        queue.Close();
+    };
+
+    auto render = [&](size_t end) {
+        try
+        {
+            for (size_t i = nextFrame++; i < end && !failed; i = nextFrame++)
+            {
+                std::seed_seq seq{options.seed, static_cast<uint32_t>(i), static_cast<uint32_t>(static_cast<uint64_t>(i) >> 32)};
+                std::mt19937 generator(seq);
+                core::TraceZone frameZone("Render frame");
+                cv::Mat frame = DrawImage(mesh, RandomTransform(generator), options.perspective, 1);
+                if (options.asyncEncoding)
+                {
+                    if (!queue.Push(i, std::move(frame)))
+                        break;
+                }
+                else
+                {
+                    writer.Write(i, frame);
+                }
+            }
+        }
+        catch (...)
+        {
+            fail();
+        }
+    };
+
+    const auto start = Clock::now();
+
+    std::thread encoder;
+    if (options.asyncEncoding)
+    {
+        encoder = std::thread([&]() {
+            core::SetTraceThreadName("Encoder");
+            try
+            {
+                std::pair<size_t, cv::Mat> item;
+                while (queue.Pop(item))
+                {
+                    writer.Write(item.first, item.second);
+                }
+            }
+            catch (...)
+            {
+                fail();
+            }
+        });
+    }
+
+    for (size_t first = 0; first < options.frames && !failed; first += window)
+    {
+        const size_t end = std::min(first + window, options.frames);
+        nextFrame = first;
+        core::ParallelFor(0, threads, 1, [&](size_t, size_t) { render(end); });
+    }
+    if (encoder.joinable())
+    {
+        queue.Close();
+        encoder.join();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("%zu kadri %.2f s laikā, %.1f kadri/s (%u pavedieni, %s kodēšana)\n",
+           options.frames, seconds, options.frames / seconds, threads,
+           options.asyncEncoding ? "asinhrona" : "sinhrona");
+}
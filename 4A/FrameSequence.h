@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "Mesh.h"
+
+struct FrameSequenceOptions{
+    size_t frames = 0;
+    // Directory for a PNG sequence, or a file ending in .raw for a stream of
+    // 8 bit grayscale SCREEN_SIZE x SCREEN_SIZE frames
+    std::string output;
+    // Frames rendered at the same time
+    unsigned threads = 1;
+    // Frame i uses a generator seeded with (seed, i)
+    uint32_t seed = 0;
+    bool perspective = false;
+    // Encode and write frames on a separate thread while rendering goes on
+    bool asyncEncoding = false;
+};
+
+// Renders frames with random transforms of the mesh on the shared thread pool
+// without opening any windows, prints the achieved frame rate
+void RenderFrameSequence(const Mesh& mesh, const FrameSequenceOptions& options);
@@ -0,0 +1,284 @@
+#include "LineRasterizer.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
+
+namespace {
+    const int TILE_SIZE = 64;
+
+    enum OutCode{
+        INSIDE = 0,
+        LEFT = 1,
+        RIGHT = 2,
+        BOTTOM = 4,
+        TOP = 8
+    };
+
+    int ComputeOutCode(double x, double y, double xmin, double ymin, double xmax, double ymax)
+    {
+        int code = INSIDE;
+        if (x < xmin)
+            code |= LEFT;
+        else if (x > xmax)
+            code |= RIGHT;
+        if (y < ymin)
+            code |= BOTTOM;
+        else if (y > ymax)
+            code |= TOP;
+        return code;
+    }
+
+    struct Line{
+        int x0, y0, x1, y1;
+    };
+
+    // Bresenham line walked along its major axis. Step k is at major
+    // coordinate m0 + sm * k and minor coordinate n0 + sn * round(k * adn / adm),
+    // halves rounded up, which is what the error accumulating loop produces.
+    struct Walk{
+        bool steep;
+        int m0, n0, sm, sn, adm, adn;
+
+        explicit Walk(const Line& l)
+        {
+            const int dx = l.x1 - l.x0, dy = l.y1 - l.y0;
+            steep = std::abs(dy) > std::abs(dx);
+            m0 = steep ? l.y0 : l.x0;
+            n0 = steep ? l.x0 : l.y0;
+            sm = (steep ? dy : dx) < 0 ? -1 : 1;
+            sn = (steep ? dx : dy) < 0 ? -1 : 1;
+            adm = std::abs(steep ? dy : dx);
+            adn = std::abs(steep ? dx : dy);
+        }
+
+        // Steps with major coordinate within [lo; hi], false if there are none
+        bool StepRange(int lo, int hi, int& kBegin, int& kEnd) const
+        {
+            kBegin = std::max(0, sm > 0 ? lo - m0 : m0 - hi);
+            kEnd = std::min(adm, sm > 0 ? hi - m0 : m0 - lo);
+            return kBegin <= kEnd;
+        }
+
+        int Minor(int k) const
+        {
+            if (adm == 0)
+                return n0;
+            return n0 + sn * static_cast<int>((2LL * k * adn + adm) / (2LL * adm));
+        }
+    };
+
+    // Clips the edge to the screen and rounds the ends to pixels
+    bool MakeLine(double x0, double y0, double x1, double y1, int size, Line& line)
+    {
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1))
+            return false;
+        if (!ClipLine(x0, y0, x1, y1, 0, 0, size - 1, size - 1))
+            return false;
+
+        auto toPixel = [=](double v) {
+            return std::min(std::max(static_cast<int>(v), 0), size - 1);
+        };
+        line = {toPixel(x0), toPixel(y0), toPixel(x1), toPixel(y1)};
+        return true;
+    }
+
+    // Moves point 0 along the edge to the near plane w = CLIP_NEAR_W
+    void ClipToNear(double& x0, double& y0, double& w0, double x1, double y1, double w1)
+    {
+        const double t = (CLIP_NEAR_W - w0) / (w1 - w0);
+        x0 += t * (x1 - x0);
+        y0 += t * (y1 - y0);
+        w0 = CLIP_NEAR_W;
+    }
+
+    // Culls edges that are entirely beyond one plane of the view volume and
+    // clips the ones crossing the near plane. Only the ends left in front of
+    // the camera are divided by w.
+    bool ProjectEdge(const ClipVertices& v, uint32_t a, uint32_t b, int size, Line& line)
+    {
+        const uint8_t codeA = v.outcode[a], codeB = v.outcode[b];
+        if ((codeA & codeB) != 0)
+            return false;
+
+        double xa = v.x[a], ya = v.y[a], wa = v.w[a];
+        double xb = v.x[b], yb = v.y[b], wb = v.w[b];
+        if (codeA & CLIP_NEAR)
+            ClipToNear(xa, ya, wa, xb, yb, wb);
+        else if (codeB & CLIP_NEAR)
+            ClipToNear(xb, yb, wb, xa, ya, wa);
+
+        return MakeLine((0.5 + xa / wa) * size, (0.5 + ya / wa) * size,
+                        (0.5 + xb / wb) * size, (0.5 + yb / wb) * size, size, line);
+    }
+
+    // Adds the line to every tile it passes through
+    void BinLine(const Line& line, int tilesPerRow, std::vector<std::vector<Line>>& bins)
+    {
+        // Most edges of a dense mesh are short and stay within one tile
+        const int firstX = line.x0 / TILE_SIZE, firstY = line.y0 / TILE_SIZE;
+        if (firstX == line.x1 / TILE_SIZE && firstY == line.y1 / TILE_SIZE)
+        {
+            bins[static_cast<size_t>(firstY * tilesPerRow + firstX)].push_back(line);
+            return;
+        }
+
+        const Walk walk(line);
+        const int mLo = std::min(walk.m0, walk.m0 + walk.sm * walk.adm);
+        const int mHi = std::max(walk.m0, walk.m0 + walk.sm * walk.adm);
+
+        for (int tm = mLo / TILE_SIZE; tm <= mHi / TILE_SIZE; tm++)
+        {
+            int kBegin, kEnd;
+            if (!walk.StepRange(tm * TILE_SIZE, tm * TILE_SIZE + TILE_SIZE - 1, kBegin, kEnd))
+                continue;
+
+            const int n1 = walk.Minor(kBegin), n2 = walk.Minor(kEnd);
+            for (int tn = std::min(n1, n2) / TILE_SIZE; tn <= std::max(n1, n2) / TILE_SIZE; tn++)
+            {
+                const int tx = walk.steep ? tn : tm;
+                const int ty = walk.steep ? tm : tn;
+                bins[static_cast<size_t>(ty * tilesPerRow + tx)].push_back(line);
+            }
+        }
+    }
+
+    void DrawLineInTile(cv::Mat& screen, const Line& line, const cv::Rect& tile)
+    {
+        const Walk walk(line);
+        const int mLo = walk.steep ? tile.y : tile.x;
+        const int mHi = (walk.steep ? tile.y + tile.height : tile.x + tile.width) - 1;
+        const int nLo = walk.steep ? tile.x : tile.y;
+        const int nHi = (walk.steep ? tile.x + tile.width : tile.y + tile.height) - 1;
+
+        int kBegin, kEnd;
+        if (!walk.StepRange(mLo, mHi, kBegin, kEnd))
+            return;
+
+        // Error term of the Bresenham loop at step kBegin
+        const long long twoAdm = 2LL * std::max(walk.adm, 1);
+        const long long num = 2LL * kBegin * walk.adn + walk.adm;
+        int n = walk.n0 + walk.sn * static_cast<int>(num / twoAdm);
+        long long err = num % twoAdm;
+        int m = walk.m0 + walk.sm * kBegin;
+
+        for (int k = kBegin; k <= kEnd; k++)
+        {
+            if (n >= nLo && n <= nHi)
+            {
+                if (walk.steep)
+                    screen.at<unsigned char>(m, n) = 255;
+                else
+                    screen.at<unsigned char>(n, m) = 255;
+            }
+            m += walk.sm;
+            err += 2LL * walk.adn;
+            if (err >= twoAdm)
+            {
+                err -= twoAdm;
+                n += walk.sn;
+            }
+        }
+    }
+}
+
+bool ClipLine(double& x0, double& y0, double& x1, double& y1,
+              double xmin, double ymin, double xmax, double ymax)
+{
+    int code0 = ComputeOutCode(x0, y0, xmin, ymin, xmax, ymax);
+    int code1 = ComputeOutCode(x1, y1, xmin, ymin, xmax, ymax);
+
+    while (true)
+    {
+        if ((code0 | code1) == 0)
+            return true;
+        if ((code0 & code1) != 0)
+            return false;
+
+        // Move the outside end to the border it is beyond
+        const int code = code0 != 0 ? code0 : code1;
+        double x, y;
+        if (code & TOP)
+        {
+            x = x0 + (x1 - x0) * (ymax - y0) / (y1 - y0);
+            y = ymax;
+        }
+        else if (code & BOTTOM)
+        {
+            x = x0 + (x1 - x0) * (ymin - y0) / (y1 - y0);
+            y = ymin;
+        }
+        else if (code & RIGHT)
+        {
+            y = y0 + (y1 - y0) * (xmax - x0) / (x1 - x0);
+            x = xmax;
+        }
+        else
+        {
+            y = y0 + (y1 - y0) * (xmin - x0) / (x1 - x0);
+            x = xmin;
+        }
+
+        if (code == code0)
+        {
+            x0 = x;
+            y0 = y;
+            code0 = ComputeOutCode(x0, y0, xmin, ymin, xmax, ymax);
+        }
+        else
+        {
+            x1 = x;
+            y1 = y;
+            code1 = ComputeOutCode(x1, y1, xmin, ymin, xmax, ymax);
+        }
+    }
+}
+
+void DrawEdges(cv::Mat& screen, const ClipVertices& vertices,
+               const std::vector<std::pair<uint32_t, uint32_t>>& edges, unsigned threads)
+{
+    assert(screen.type() == CV_8U && screen.rows == screen.cols);
+
+    const int size = screen.cols;
+    const int tilesPerRow = (size + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tileCount = static_cast<size_t>(tilesPerRow) * tilesPerRow;
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(tileCount)));
+
+    // Every thread bins its own share of the edges, the bins are merged per tile
+    std::vector<std::vector<std::vector<Line>>> bins(threads, std::vector<std::vector<Line>>(tileCount));
+    core::ParallelFor(0, threads, 1, [&](size_t t, size_t) {
+        core::TraceZone binZone("Bin edges");
+        const size_t begin = edges.size() * t / threads;
+        const size_t end = edges.size() * (t + 1) / threads;
+        Line line;
+        for (size_t i = begin; i < end; i++)
+        {
+            if (ProjectEdge(vertices, edges[i].first, edges[i].second, size, line))
+            {
+                BinLine(line, tilesPerRow, bins[t]);
+            }
+        }
+    });
+
+    // The same threads take tiles in turn, one of them runs inline
+    std::atomic<size_t> nextTile(0);
+    core::ParallelFor(0, threads, 1, [&](size_t, size_t) {
+        for (size_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+        {
+            core::TraceZone tileZone("Draw tile");
+            const int x0 = static_cast<int>(tile % static_cast<size_t>(tilesPerRow)) * TILE_SIZE;
+            const int y0 = static_cast<int>(tile / static_cast<size_t>(tilesPerRow)) * TILE_SIZE;
+            const cv::Rect rect(x0, y0, std::min(TILE_SIZE, size - x0), std::min(TILE_SIZE, size - y0));
+            for (const auto& threadBins : bins)
+            {
+                for (const Line& line : threadBins[tile])
+                {
+                    DrawLineInTile(screen, line, rect);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "Mesh.h"
+
+// Cohen–Sutherland clipping of a segment to [xmin; xmax] x [ymin; ymax].
+// Returns false if nothing of the segment is left.
+bool ClipLine(double& x0, double& y0, double& x1, double& y1,
+              double xmin, double ymin, double xmax, double ymax);
+
+// Draws the mesh edges with Bresenham lines. Edges are culled and clipped
+// against the view volume, divided by w and clipped to the screen. They are
+// binned into square tiles in threads shares and the tiles are drawn by
+// threads tasks of the shared thread pool, the result does not depend on the
+// thread count.
+void DrawEdges(cv::Mat& screen, const ClipVertices& vertices,
+               const std::vector<std::pair<uint32_t, uint32_t>>& edges, unsigned threads);
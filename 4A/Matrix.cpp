@@ -0,0 +1,222 @@
+#include "Matrix.h"
+#include "Simd.h"
+
+// Every sum starts from zero like in the generic loops, so that even the
+// sign of zero results is the same.
+
+#ifdef WIREFRAME_SIMD
+
+namespace {
+    struct Columns4f{
+        __m128 c[4];
+
+        explicit Columns4f(const Mat4<float>& m)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                c[j] = _mm_set_ps(m.val[3][j], m.val[2][j], m.val[1][j], m.val[0][j]);
+            }
+        }
+
+        void transform(const float* in, float* out) const
+        {
+            __m128 r = _mm_setzero_ps();
+            r = _mm_add_ps(r, _mm_mul_ps(c[0], _mm_set1_ps(in[0])));
+            r = _mm_add_ps(r, _mm_mul_ps(c[1], _mm_set1_ps(in[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(c[2], _mm_set1_ps(in[2])));
+            r = _mm_add_ps(r, _mm_mul_ps(c[3], _mm_set1_ps(in[3])));
+            _mm_storeu_ps(out, r);
+        }
+    };
+
+#ifdef __AVX__
+    struct Columns4d{
+        __m256d c[4];
+
+        explicit Columns4d(const Mat4<double>& m)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                c[j] = _mm256_set_pd(m.val[3][j], m.val[2][j], m.val[1][j], m.val[0][j]);
+            }
+        }
+
+        void transform(const double* in, double* out) const
+        {
+            __m256d r = _mm256_setzero_pd();
+            r = _mm256_add_pd(r, _mm256_mul_pd(c[0], _mm256_set1_pd(in[0])));
+            r = _mm256_add_pd(r, _mm256_mul_pd(c[1], _mm256_set1_pd(in[1])));
+            r = _mm256_add_pd(r, _mm256_mul_pd(c[2], _mm256_set1_pd(in[2])));
+            r = _mm256_add_pd(r, _mm256_mul_pd(c[3], _mm256_set1_pd(in[3])));
+            _mm256_storeu_pd(out, r);
+        }
+    };
+#else
+    // Without AVX a column of doubles is split in two SSE2 halves
+    struct Columns4d{
+        __m128d lo[4], hi[4];
+
+        explicit Columns4d(const Mat4<double>& m)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                lo[j] = _mm_set_pd(m.val[1][j], m.val[0][j]);
+                hi[j] = _mm_set_pd(m.val[3][j], m.val[2][j]);
+            }
+        }
+
+        void transform(const double* in, double* out) const
+        {
+            __m128d rlo = _mm_setzero_pd();
+            __m128d rhi = _mm_setzero_pd();
+            for (int j = 0; j < 4; j++)
+            {
+                __m128d v = _mm_set1_pd(in[j]);
+                rlo = _mm_add_pd(rlo, _mm_mul_pd(lo[j], v));
+                rhi = _mm_add_pd(rhi, _mm_mul_pd(hi[j], v));
+            }
+            _mm_storeu_pd(out, rlo);
+            _mm_storeu_pd(out + 2, rhi);
+        }
+    };
+#endif
+}
+
+template <>
+Mat4<float> Mat4<float>::operator*(const Mat4<float>& lhs) const
+{
+    const __m128 b0 = _mm_loadu_ps(lhs.val[0]);
+    const __m128 b1 = _mm_loadu_ps(lhs.val[1]);
+    const __m128 b2 = _mm_loadu_ps(lhs.val[2]);
+    const __m128 b3 = _mm_loadu_ps(lhs.val[3]);
+
+    Mat4<float> tmp;
+    for (int i = 0; i < 4; i++)
+    {
+        __m128 r = _mm_setzero_ps();
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(val[i][0]), b0));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(val[i][1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(val[i][2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(val[i][3]), b3));
+        _mm_storeu_ps(tmp.val[i], r);
+    }
+    return tmp;
+}
+
+template <>
+Mat4<double> Mat4<double>::operator*(const Mat4<double>& lhs) const
+{
+    Mat4<double> tmp;
+#ifdef __AVX__
+    const __m256d b0 = _mm256_loadu_pd(lhs.val[0]);
+    const __m256d b1 = _mm256_loadu_pd(lhs.val[1]);
+    const __m256d b2 = _mm256_loadu_pd(lhs.val[2]);
+    const __m256d b3 = _mm256_loadu_pd(lhs.val[3]);
+    for (int i = 0; i < 4; i++)
+    {
+        __m256d r = _mm256_setzero_pd();
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_set1_pd(val[i][0]), b0));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_set1_pd(val[i][1]), b1));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_set1_pd(val[i][2]), b2));
+        r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_set1_pd(val[i][3]), b3));
+        _mm256_storeu_pd(tmp.val[i], r);
+    }
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        __m128d rlo = _mm_setzero_pd();
+        __m128d rhi = _mm_setzero_pd();
+        for (int k = 0; k < 4; k++)
+        {
+            __m128d a = _mm_set1_pd(val[i][k]);
+            rlo = _mm_add_pd(rlo, _mm_mul_pd(a, _mm_loadu_pd(lhs.val[k])));
+            rhi = _mm_add_pd(rhi, _mm_mul_pd(a, _mm_loadu_pd(lhs.val[k] + 2)));
+        }
+        _mm_storeu_pd(tmp.val[i], rlo);
+        _mm_storeu_pd(tmp.val[i] + 2, rhi);
+    }
+#endif
+    return tmp;
+}
+
+template <>
+Vec4<float> Mat4<float>::operator*(const Vec4<float>& lhs) const
+{
+    Vec4<float> tmp;
+    Columns4f(*this).transform(lhs.val, tmp.val);
+    return tmp;
+}
+
+template <>
+Vec4<double> Mat4<double>::operator*(const Vec4<double>& lhs) const
+{
+    Vec4<double> tmp;
+    Columns4d(*this).transform(lhs.val, tmp.val);
+    return tmp;
+}
+
+template <>
+void TransformPoints(const Mat4<float>& mat, Vec4<float>* points, size_t count)
+{
+    const Columns4f columns(mat);
+    for (size_t i = 0; i < count; i++)
+    {
+        columns.transform(points[i].val, points[i].val);
+    }
+}
+
+template <>
+void TransformPoints(const Mat4<double>& mat, Vec4<double>* points, size_t count)
+{
+    const Columns4d columns(mat);
+    for (size_t i = 0; i < count; i++)
+    {
+        columns.transform(points[i].val, points[i].val);
+    }
+}
+
+#else
+
+template <>
+Mat4<float> Mat4<float>::operator*(const Mat4<float>& lhs) const
+{
+    return multiplyGeneric(*this, lhs);
+}
+
+template <>
+Mat4<double> Mat4<double>::operator*(const Mat4<double>& lhs) const
+{
+    return multiplyGeneric(*this, lhs);
+}
+
+template <>
+Vec4<float> Mat4<float>::operator*(const Vec4<float>& lhs) const
+{
+    return transformGeneric(*this, lhs);
+}
+
+template <>
+Vec4<double> Mat4<double>::operator*(const Vec4<double>& lhs) const
+{
+    return transformGeneric(*this, lhs);
+}
+
+template <>
+void TransformPoints(const Mat4<float>& mat, Vec4<float>* points, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = Mat4<float>::transformGeneric(mat, points[i]);
+    }
+}
+
+template <>
+void TransformPoints(const Mat4<double>& mat, Vec4<double>* points, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = Mat4<double>::transformGeneric(mat, points[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+
+template <typename T>
+struct Vec4{
+    T val[4];
+
+    static constexpr Vec4<T> getPos(const T& x, const T& y, const T& z)
+    {
+        return {x, y, z, 1};
+    }
+
+    static constexpr Vec4<T> getDirection(const T& x, const T& y, const T& z)
+    {
+        return {x, y, z, 0};
+    }
+
+    constexpr Vec4<T> operator-() const
+    {
+        return {-val[0], -val[1], -val[2], val[3]};
+    }
+
+    T length() const
+    {
+        return sqrt(val[0] * val[0] + val[1] * val[1] + val[2] * val[2]);
+    }
+
+    Vec4<T> normalize() const
+    {
+        T l = length();
+        return {
+            val[0] / l,
+            val[1] / l,
+            val[2] / l,
+            val[3]
+        };
+    }
+
+    constexpr Vec4<T> cross(const Vec4<T>& r) const
+    {
+        return {
+            val[1] * r.val[2] - val[2] * r.val[1],
+            val[2] * r.val[0] - val[0] * r.val[2],
+            val[0] * r.val[1] - val[1] * r.val[0],
+            0
+        };
+    }
+
+    constexpr Vec4<T> operator-(const Vec4<T>& r) const
+    {
+        // Assume - both points with the same W
+        return {val[0] - r.val[0], val[1] - r.val[1], val[2] - r.val[2], val[3]};
+    }
+
+    Vec4<T> toScreen() const
+    {
+        return {val[0] / val[3], val[1] / val[3], val[2] / val[3], 1};
+    }
+};
+
+template <typename T>
+struct Mat4{
+    T val[4][4];
+
+    // Reference products, float and double specializations of the operators
+    // below must give exactly the same results
+    static constexpr Mat4<T> multiplyGeneric(const Mat4<T>& l, const Mat4<T>& r)
+    {
+        Mat4<T> tmp{};
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                tmp.val[i][j] = 0;
+                for (int k = 0; k < 4; k++)
+                {
+                    tmp.val[i][j] += l.val[i][k] * r.val[k][j];
+                }
+            }
+        }
+        return tmp;
+    }
+
+    static constexpr Vec4<T> transformGeneric(const Mat4<T>& l, const Vec4<T>& r)
+    {
+        Vec4<T> tmp{};
+        for (int i = 0; i < 4; i++)
+        {
+            tmp.val[i] = 0;
+            for (int j = 0; j < 4; j++)
+            {
+                tmp.val[i] += l.val[i][j] * r.val[j];
+            }
+        }
+        return tmp;
+    }
+
+    // True if the last row is exactly (0, 0, 0, 1)
+    constexpr bool isAffine() const
+    {
+        auto exactly = [](T v, T expected) { return !(v < expected) && !(v > expected); };
+        return exactly(val[3][0], 0) && exactly(val[3][1], 0) && exactly(val[3][2], 0) && exactly(val[3][3], 1);
+    }
+
+    // Product of two affine matrices, only the top 3x4 part is computed.
+    // Equal to multiplyGeneric up to the sign of zero elements.
+    static constexpr Mat4<T> multiplyAffine(const Mat4<T>& l, const Mat4<T>& r)
+    {
+        Mat4<T> tmp{};
+        for (int i = 0; i < 3; i++)
+        {
+            const T a = l.val[i][0], b = l.val[i][1], c = l.val[i][2];
+            for (int j = 0; j < 4; j++)
+            {
+                tmp.val[i][j] = a * r.val[0][j] + b * r.val[1][j] + c * r.val[2][j];
+            }
+            tmp.val[i][3] += l.val[i][3];
+        }
+        tmp.val[3][3] = 1;
+        return tmp;
+    }
+
+    // Left to right product of count factors, see Compose below
+    static constexpr Mat4<T> composeChain(const Mat4<T>* const* factors, size_t count)
+    {
+        Mat4<T> product = *factors[0];
+        for (size_t i = 1; i < count; i++)
+        {
+            product = product.isAffine() && factors[i]->isAffine() ? multiplyAffine(product, *factors[i])
+                                                                   : multiplyGeneric(product, *factors[i]);
+        }
+        return product;
+    }
+
+    Mat4<T> operator*(const Mat4<T>& lhs) const
+    {
+        return multiplyGeneric(*this, lhs);
+    }
+
+    Vec4<T> operator*(const Vec4<T>& lhs) const
+    {
+        return transformGeneric(*this, lhs);
+    }
+
+    static Mat4<T> getRoationX(double rad)
+    {
+        return {
+            1, 0, 0, 0,
+            0, cos(rad), -sin(rad), 0,
+            0, sin(rad), cos(rad), 0,
+            0, 0, 0, 1,
+        };
+    }
+
+    static Mat4<T> getRoationY(double rad)
+    {
+        return {
+            cos(rad), 0, sin(rad), 0,
+            0, 1, 0, 0,
+            -sin(rad), 0, cos(rad), 0,
+            0, 0, 0, 1,
+        };
+    }
+
+    static Mat4<T> getRoationZ(double rad)
+    {
+        return {
+            cos(rad), -sin(rad), 0, 0,
+            sin(rad), cos(rad), 0, 0,
+            0, 0, 1, 0,
+            0, 0, 0, 1,
+        };
+    }
+
+    static constexpr Mat4<T> getScale(T x, T y, T z)
+    {
+        return {
+            x, 0, 0, 0,
+            0, y, 0, 0,
+            0, 0, z, 0,
+            0, 0, 0, 1,
+        };
+    }
+
+    static constexpr Mat4<T> getUnit()
+    {
+        return getScale(1, 1, 1);
+    }
+
+    static constexpr Mat4<T> getTranslate(T x, T y, T z)
+    {
+        return {
+            1, 0, 0, x,
+            0, 1, 0, y,
+            0, 0, 1, z,
+            0, 0, 0, 1,
+        };
+    }
+
+    static constexpr Mat4<T> getTranslate(const Vec4<T>& vec)
+    {
+        return getTranslate(vec.val[0], vec.val[1], vec.val[2]);
+    }
+
+    static constexpr Mat4<T> getXYShearing(T coef)
+    {
+        return {
+            1, coef, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, 0, 1,
+        };
+    }
+
+    static constexpr Mat4<T> getPerspectiveProjection(T coef)
+    {
+        return {
+            1, 0, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, -1 / coef, 0
+        };
+    }
+};
+
+// Transforms count points in place
+template <typename T>
+void TransformPoints(const Mat4<T>& mat, Vec4<T>* points, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = mat * points[i];
+    }
+}
+
+// Product of a chain of transforms, grouped from the left like a * b * c.
+// Affine pairs take the 3x4 path, chains of constexpr factors are folded at
+// compile time.
+template <typename T, typename... Rest>
+constexpr Mat4<T> Compose(const Mat4<T>& first, const Rest&... rest)
+{
+    const Mat4<T>* factors[] = {&first, &rest...};
+    return Mat4<T>::composeChain(factors, sizeof...(Rest) + 1);
+}
+
+// SSE / AVX versions (Matrix.cpp), the result row is built from rows of the
+// right matrix (or matrix columns for vectors) scaled by broadcast elements,
+// in the same order as the generic loops.
+template <> Mat4<float> Mat4<float>::operator*(const Mat4<float>& lhs) const;
+template <> Vec4<float> Mat4<float>::operator*(const Vec4<float>& lhs) const;
+template <> Mat4<double> Mat4<double>::operator*(const Mat4<double>& lhs) const;
+template <> Vec4<double> Mat4<double>::operator*(const Vec4<double>& lhs) const;
+template <> void TransformPoints(const Mat4<float>& mat, Vec4<float>* points, size_t count);
+template <> void TransformPoints(const Mat4<double>& mat, Vec4<double>* points, size_t count);
+
+template<typename T>
+Mat4<T> CameraLookAt(const Vec4<T>& cameraPos, const Vec4<T>& lookTo, const Vec4<T>& up)
+{
+    auto forward = (cameraPos - lookTo).normalize();
+    auto right = up.normalize().cross(forward);
+    auto rup = forward.cross(right);
+    return Mat4<T>{
+        right.val[0], right.val[1], right.val[2], 0,
+        rup.val[0], rup.val[1], rup.val[2], 0,
+        forward.val[0], forward.val[1], forward.val[2], 0,
+        0, 0, 0, 1,
+    } * Mat4<double>::getTranslate(-cameraPos);
+}
@@ -0,0 +1,143 @@
+#include "Mesh.h"
+#include "Simd.h"
+
+#include <algorithm>
+
+Mesh::~Mesh() = default;
+ClipVertices::~ClipVertices() = default;
+
+namespace {
+    uint8_t OutCode(double x, double y, double w)
+    {
+        const double h = w * 0.5;
+        return static_cast<uint8_t>((x < -h ? CLIP_LEFT : 0) | (x > h ? CLIP_RIGHT : 0) |
+                                    (y < -h ? CLIP_BOTTOM : 0) | (y > h ? CLIP_TOP : 0) |
+                                    (w < CLIP_NEAR_W ? CLIP_NEAR : 0));
+    }
+
+    // Combines per lane comparison masks into outcodes
+    void StoreOutCodes(uint8_t* out, int lanes, int left, int right, int bottom, int top, int near)
+    {
+        for (int j = 0; j < lanes; j++)
+        {
+            out[j] = static_cast<uint8_t>((((left >> j) & 1) * CLIP_LEFT) | (((right >> j) & 1) * CLIP_RIGHT) |
+                                          (((bottom >> j) & 1) * CLIP_BOTTOM) | (((top >> j) & 1) * CLIP_TOP) |
+                                          (((near >> j) & 1) * CLIP_NEAR));
+        }
+    }
+}
+
+void FitMesh(Mesh& mesh, double radius)
+{
+    if (mesh.VertexCount() == 0)
+        return;
+
+    std::vector<double>* axes[3] = {&mesh.x, &mesh.y, &mesh.z};
+    double centre[3];
+    for (int k = 0; k < 3; k++)
+    {
+        auto range = std::minmax_element(axes[k]->begin(), axes[k]->end());
+        centre[k] = (*range.first + *range.second) / 2;
+    }
+
+    double farthest = 0;
+    for (size_t i = 0; i < mesh.VertexCount(); i++)
+    {
+        const double dx = mesh.x[i] - centre[0], dy = mesh.y[i] - centre[1], dz = mesh.z[i] - centre[2];
+        farthest = std::max(farthest, dx * dx + dy * dy + dz * dz);
+    }
+    const double scale = farthest > 0 ? radius / sqrt(farthest) : 1;
+
+    for (int k = 0; k < 3; k++)
+    {
+        for (double& v : *axes[k])
+        {
+            v = (v - centre[k]) * scale;
+        }
+    }
+}
+
+// Sums are formed in the same order as Mat4::transformGeneric, the w = 1
+// column is added last without a multiply.
+void TransformVertices(const Mesh& mesh, const Mat4<double>& mat, ClipVertices& out)
+{
+    const size_t n = mesh.VertexCount();
+    out.x.resize(n);
+    out.y.resize(n);
+    out.w.resize(n);
+    out.outcode.resize(n);
+
+    const auto& m = mat.val;
+    const double* px = mesh.x.data();
+    const double* py = mesh.y.data();
+    const double* pz = mesh.z.data();
+    size_t i = 0;
+
+#if defined(WIREFRAME_SIMD) && defined(__AVX__)
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d nearW = _mm256_set1_pd(CLIP_NEAR_W);
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256d x = _mm256_loadu_pd(px + i);
+        const __m256d y = _mm256_loadu_pd(py + i);
+        const __m256d z = _mm256_loadu_pd(pz + i);
+        __m256d r[4];
+        for (int k : {0, 1, 3})
+        {
+            r[k] = _mm256_mul_pd(_mm256_set1_pd(m[k][0]), x);
+            r[k] = _mm256_add_pd(r[k], _mm256_mul_pd(_mm256_set1_pd(m[k][1]), y));
+            r[k] = _mm256_add_pd(r[k], _mm256_mul_pd(_mm256_set1_pd(m[k][2]), z));
+            r[k] = _mm256_add_pd(r[k], _mm256_set1_pd(m[k][3]));
+        }
+        _mm256_storeu_pd(&out.x[i], r[0]);
+        _mm256_storeu_pd(&out.y[i], r[1]);
+        _mm256_storeu_pd(&out.w[i], r[3]);
+
+        const __m256d h = _mm256_mul_pd(r[3], half);
+        const __m256d nh = _mm256_sub_pd(_mm256_setzero_pd(), h);
+        StoreOutCodes(&out.outcode[i], 4,
+                      _mm256_movemask_pd(_mm256_cmp_pd(r[0], nh, _CMP_LT_OQ)),
+                      _mm256_movemask_pd(_mm256_cmp_pd(r[0], h, _CMP_GT_OQ)),
+                      _mm256_movemask_pd(_mm256_cmp_pd(r[1], nh, _CMP_LT_OQ)),
+                      _mm256_movemask_pd(_mm256_cmp_pd(r[1], h, _CMP_GT_OQ)),
+                      _mm256_movemask_pd(_mm256_cmp_pd(r[3], nearW, _CMP_LT_OQ)));
+    }
+#elif defined(WIREFRAME_SIMD)
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d nearW = _mm_set1_pd(CLIP_NEAR_W);
+    for (; i + 2 <= n; i += 2)
+    {
+        const __m128d x = _mm_loadu_pd(px + i);
+        const __m128d y = _mm_loadu_pd(py + i);
+        const __m128d z = _mm_loadu_pd(pz + i);
+        __m128d r[4];
+        for (int k : {0, 1, 3})
+        {
+            r[k] = _mm_mul_pd(_mm_set1_pd(m[k][0]), x);
+            r[k] = _mm_add_pd(r[k], _mm_mul_pd(_mm_set1_pd(m[k][1]), y));
+            r[k] = _mm_add_pd(r[k], _mm_mul_pd(_mm_set1_pd(m[k][2]), z));
+            r[k] = _mm_add_pd(r[k], _mm_set1_pd(m[k][3]));
+        }
+        _mm_storeu_pd(&out.x[i], r[0]);
+        _mm_storeu_pd(&out.y[i], r[1]);
+        _mm_storeu_pd(&out.w[i], r[3]);
+
+        const __m128d h = _mm_mul_pd(r[3], half);
+        const __m128d nh = _mm_sub_pd(_mm_setzero_pd(), h);
+        StoreOutCodes(&out.outcode[i], 2,
+                      _mm_movemask_pd(_mm_cmplt_pd(r[0], nh)),
+                      _mm_movemask_pd(_mm_cmpgt_pd(r[0], h)),
+                      _mm_movemask_pd(_mm_cmplt_pd(r[1], nh)),
+                      _mm_movemask_pd(_mm_cmpgt_pd(r[1], h)),
+                      _mm_movemask_pd(_mm_cmplt_pd(r[3], nearW)));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        out.x[i] = m[0][0] * px[i] + m[0][1] * py[i] + m[0][2] * pz[i] + m[0][3];
+        out.y[i] = m[1][0] * px[i] + m[1][1] * py[i] + m[1][2] * pz[i] + m[1][3];
+        out.w[i] = m[3][0] * px[i] + m[3][1] * py[i] + m[3][2] * pz[i] + m[3][3];
+        out.outcode[i] = OutCode(out.x[i], out.y[i], out.w[i]);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "Matrix.h"
+
+// Wireframe model. Vertex coordinates are kept in separate arrays (w is
+// always 1) and edges refer to vertices by index, so that a vertex shared
+// by many edges is transformed only once.
+struct Mesh{
+    std::vector<double> x, y, z;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+
+    Mesh() = default;
+    Mesh(Mesh&&) noexcept = default;
+    Mesh& operator=(Mesh&&) noexcept = default;
+    ~Mesh();
+
+    size_t VertexCount() const
+    {
+        return x.size();
+    }
+
+    uint32_t AddVertex(double vx, double vy, double vz)
+    {
+        x.push_back(vx);
+        y.push_back(vy);
+        z.push_back(vz);
+        return static_cast<uint32_t>(x.size() - 1);
+    }
+};
+
+// Moves the bounding box centre to the origin and scales the model so that
+// its farthest vertex is at the given distance
+void FitMesh(Mesh& mesh, double radius);
+
+// Bits of ClipVertices::outcode, one for every plane of the view volume
+// |x| <= w / 2, |y| <= w / 2, w >= CLIP_NEAR_W that the vertex is outside of.
+// Both projections map this volume to the whole screen.
+enum ClipPlane : uint8_t{
+    CLIP_LEFT = 1,
+    CLIP_RIGHT = 2,
+    CLIP_BOTTOM = 4,
+    CLIP_TOP = 8,
+    CLIP_NEAR = 16
+};
+
+const double CLIP_NEAR_W = 1e-5;
+
+// Transformed mesh vertices in homogeneous coordinates, not yet divided by w
+struct ClipVertices{
+    std::vector<double> x, y, w;
+    std::vector<uint8_t> outcode;
+
+    ClipVertices() = default;
+    ~ClipVertices();
+};
+
+// Transforms all vertices by mat and classifies them against the view volume
+void TransformVertices(const Mesh& mesh, const Mat4<double>& mat, ClipVertices& out);
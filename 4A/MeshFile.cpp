@@ -0,0 +1,695 @@
+#include "MeshFile.h"
+
+#include <string.h>
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <sstream>
+
+#include "core/MappedFile.h"
+#include "core/Trace.h"
+#include "core/Utility.h"
+
+namespace {
+    // Longest PLY header accepted, in bytes
+    const size_t MAX_PLY_HEADER = 1 << 16;
+
+    // Open addressing set of undirected edges. Keys pack the smaller index in
+    // the high half, so 0 can only be the degenerate edge (0, 0) and marks an
+    // empty slot.
+    class EdgeSet{
+        std::vector<uint64_t> slots;
+        size_t count = 0;
+
+        static size_t Hash(uint64_t key)
+        {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            return static_cast<size_t>(key);
+        }
+
+        void Grow()
+        {
+            std::vector<uint64_t> old(std::max<size_t>(slots.size() * 2, 1024), 0);
+            old.swap(slots);
+            for (uint64_t key : old)
+            {
+                if (key != 0)
+                {
+                    Place(key);
+                }
+            }
+        }
+
+        bool Place(uint64_t key)
+        {
+            const size_t mask = slots.size() - 1;
+            for (size_t i = Hash(key) & mask; ; i = (i + 1) & mask)
+            {
+                if (slots[i] == key)
+                {
+                    return false;
+                }
+                if (slots[i] == 0)
+                {
+                    slots[i] = key;
+                    return true;
+                }
+            }
+        }
+    public:
+        // Adds edge (a, b) to the mesh unless it is already there
+        void Add(Mesh& mesh, uint32_t a, uint32_t b)
+        {
+            if (a == b)
+            {
+                return;
+            }
+            if ((count + 1) * 2 > slots.size())
+            {
+                Grow();
+            }
+            const uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            if (Place(key))
+            {
+                ++count;
+                mesh.edges.emplace_back(std::min(a, b), std::max(a, b));
+            }
+        }
+    };
+
+    // Adds the sides of a polygon face, the last vertex connects to the first
+    void AddFace(Mesh& mesh, EdgeSet& edgeSet, const std::vector<uint32_t>& face)
+    {
+        for (size_t i = 0; i < face.size(); i++)
+        {
+            edgeSet.Add(mesh, face[i], face[i + 1 == face.size() ? 0 : i + 1]);
+        }
+    }
+
+    void PrintSummary(const Mesh& mesh)
+    {
+        std::cout << "Modelis ar " << mesh.VertexCount() << " virsotnēm, "
+                  << mesh.edges.size() << " šķautnēm" << std::endl;
+    }
+
+    bool IsBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    class TextCursor{
+        const char* pos;
+        const char* end;
+        const std::string* path;
+    public:
+        TextCursor(const char* begin, const char* endArg, const std::string& pathArg)
+            : pos(begin)
+            , end(endArg)
+            , path(&pathArg)
+        { }
+
+        const char* Position() const
+        {
+            return pos;
+        }
+
+        bool AtEnd() const
+        {
+            return pos == end;
+        }
+
+        // Skips spaces and, if asked, line breaks
+        void SkipBlank(bool newLines)
+        {
+            while (pos != end && (IsBlank(*pos) || (newLines && *pos == '\n')))
+            {
+                ++pos;
+            }
+        }
+
+        bool AtLineEnd()
+        {
+            SkipBlank(false);
+            return pos == end || *pos == '\n' || *pos == '#';
+        }
+
+        void SkipLine()
+        {
+            pos = std::find(pos, end, '\n');
+            if (pos != end)
+            {
+                ++pos;
+            }
+        }
+
+        std::string Word()
+        {
+            SkipBlank(false);
+            const char* begin = pos;
+            while (pos != end && !IsBlank(*pos) && *pos != '\n')
+            {
+                ++pos;
+            }
+            return std::string(begin, pos);
+        }
+
+        // Next number on the current line
+        template <typename T>
+        T Number()
+        {
+            if (AtLineEnd())
+            {
+                throw GrafikaException("Rindā trūkst skaitļu failā: " + *path);
+            }
+            T value;
+            auto res = std::from_chars(pos, end, value);
+            if (res.ec != std::errc())
+            {
+                throw GrafikaException("Nekorekts skaitlis failā: " + *path);
+            }
+            pos = res.ptr;
+            return value;
+        }
+
+        // Skips the rest of an OBJ "v/vt/vn" triplet
+        void SkipIndexSuffix()
+        {
+            while (pos != end && !IsBlank(*pos) && *pos != '\n')
+            {
+                ++pos;
+            }
+        }
+    };
+
+    enum class PlyType{
+        Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+    };
+
+    enum class PlyFormat{
+        Ascii, LittleEndian, BigEndian
+    };
+
+    struct PlyProperty{
+        std::string name;
+        PlyType type;
+        bool isList;
+        PlyType countType;
+    };
+
+    struct PlyElement{
+        std::string name;
+        uint64_t count;
+        std::vector<PlyProperty> properties;
+    };
+
+    PlyType ParsePlyType(const std::string& name, const std::string& path)
+    {
+        if (name == "char" || name == "int8") return PlyType::Int8;
+        if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+        if (name == "short" || name == "int16") return PlyType::Int16;
+        if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+        if (name == "int" || name == "int32") return PlyType::Int32;
+        if (name == "uint" || name == "uint32") return PlyType::UInt32;
+        if (name == "float" || name == "float32") return PlyType::Float32;
+        if (name == "double" || name == "float64") return PlyType::Float64;
+        throw GrafikaException("Nezināms PLY īpašības tips '" + name + "' failā: " + path);
+    }
+
+    size_t PlyTypeSize(PlyType type)
+    {
+        switch (type)
+        {
+        case PlyType::Int8:
+        case PlyType::UInt8:
+            return 1;
+        case PlyType::Int16:
+        case PlyType::UInt16:
+            return 2;
+        case PlyType::Int32:
+        case PlyType::UInt32:
+        case PlyType::Float32:
+            return 4;
+        case PlyType::Float64:
+            return 8;
+        default:
+            break;
+        }
+        return 0;
+    }
+
+    bool IsHostLittleEndian()
+    {
+        const uint16_t probe = 1;
+        unsigned char first;
+        memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    // Reads PLY element data, values are converted to double or int64_t
+    class PlyReader{
+        // Current ASCII element line
+        TextCursor line;
+        const char* pos;
+        const char* end;
+        PlyFormat format;
+        bool swap;
+        const std::string& path;
+
+        // Pointer to size bytes in file byte order converted to host order
+        const unsigned char* Take(size_t size, unsigned char* buffer)
+        {
+            if (static_cast<size_t>(end - pos) < size)
+            {
+                throw GrafikaException("PLY failā trūkst datu: " + path);
+            }
+            memcpy(buffer, pos, size);
+            pos += size;
+            if (swap)
+            {
+                std::reverse(buffer, buffer + size);
+            }
+            return buffer;
+        }
+
+        template <typename T>
+        T Binary()
+        {
+            unsigned char buffer[sizeof(T)];
+            T value;
+            memcpy(&value, Take(sizeof(T), buffer), sizeof(T));
+            return value;
+        }
+    public:
+        PlyReader(const char* begin, const char* endArg, PlyFormat formatArg, const std::string& pathArg)
+            : line(begin, begin, pathArg)
+            , pos(begin)
+            , end(endArg)
+            , format(formatArg)
+            , swap((formatArg == PlyFormat::LittleEndian) != IsHostLittleEndian())
+            , path(pathArg)
+        { }
+
+        // ASCII elements are one per line, the values are read only from the
+        // next line that is not blank
+        void StartElement()
+        {
+            if (format != PlyFormat::Ascii)
+            {
+                return;
+            }
+            do
+            {
+                if (pos == end)
+                {
+                    throw GrafikaException("PLY failā trūkst datu: " + path);
+                }
+                const char* lineEnd = std::find(pos, end, '\n');
+                line = TextCursor(pos, lineEnd, path);
+                pos = lineEnd == end ? end : lineEnd + 1;
+                line.SkipBlank(false);
+            } while (line.AtEnd());
+        }
+
+        // An ASCII element line must hold exactly the element's values
+        void FinishElement()
+        {
+            if (format != PlyFormat::Ascii)
+            {
+                return;
+            }
+            line.SkipBlank(false);
+            if (!line.AtEnd())
+            {
+                throw GrafikaException("PLY elementa rindā ir lieki dati failā: " + path);
+            }
+        }
+
+        double Real(PlyType type)
+        {
+            if (format == PlyFormat::Ascii)
+            {
+                return line.Number<double>();
+            }
+            switch (type)
+            {
+            case PlyType::Float32:
+                return Binary<float>();
+            case PlyType::Float64:
+                return Binary<double>();
+            case PlyType::Int8:
+            case PlyType::UInt8:
+            case PlyType::Int16:
+            case PlyType::UInt16:
+            case PlyType::Int32:
+            case PlyType::UInt32:
+                return static_cast<double>(Integer(type));
+            default:
+                break;
+            }
+            return 0;
+        }
+
+        int64_t Integer(PlyType type)
+        {
+            if (format == PlyFormat::Ascii)
+            {
+                return line.Number<int64_t>();
+            }
+            switch (type)
+            {
+            case PlyType::Int8:
+                return Binary<int8_t>();
+            case PlyType::UInt8:
+                return Binary<uint8_t>();
+            case PlyType::Int16:
+                return Binary<int16_t>();
+            case PlyType::UInt16:
+                return Binary<uint16_t>();
+            case PlyType::Int32:
+                return Binary<int32_t>();
+            case PlyType::UInt32:
+                return Binary<uint32_t>();
+            case PlyType::Float32:
+            case PlyType::Float64:
+            default:
+                break;
+            }
+            throw GrafikaException("PLY saraksta garumam un indeksiem jābūt veseliem skaitļiem: " + path);
+        }
+
+        void Skip(const PlyProperty& property)
+        {
+            if (format == PlyFormat::Ascii)
+            {
+                const int64_t count = property.isList ? line.Number<int64_t>() : 1;
+                for (int64_t i = 0; i < count; i++)
+                {
+                    line.Number<double>();
+                }
+                return;
+            }
+            const int64_t count = property.isList ? Integer(property.countType) : 1;
+            const size_t size = PlyTypeSize(property.type) * static_cast<size_t>(std::max<int64_t>(count, 0));
+            if (static_cast<size_t>(end - pos) < size)
+            {
+                throw GrafikaException("PLY failā trūkst datu: " + path);
+            }
+            pos += size;
+        }
+    };
+
+    // Fewest bytes an element can take: binary sizes without list items, or a
+    // digit and a separator per ASCII value
+    uint64_t MinElementSize(const PlyElement& element, PlyFormat format)
+    {
+        uint64_t size = 0;
+        for (const auto& property : element.properties)
+        {
+            size += format == PlyFormat::Ascii ? 2 : PlyTypeSize(property.isList ? property.countType : property.type);
+        }
+        return std::max<uint64_t>(size, 1);
+    }
+
+    uint32_t CheckIndex(int64_t index, size_t vertexCount, const std::string& path)
+    {
+        if (index < 0 || static_cast<uint64_t>(index) >= vertexCount)
+        {
+            throw GrafikaException("Virsotnes indekss ārpus robežām failā: " + path);
+        }
+        return static_cast<uint32_t>(index);
+    }
+
+    std::string Extension(const std::string& path)
+    {
+        const size_t dot = path.find_last_of('.');
+        std::string ext = dot == std::string::npos ? "" : path.substr(dot + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+                       [](char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+        return ext;
+    }
+}
+
+Mesh LoadObjMesh(const std::string& path)
+{
+    core::MappedFile file(path);
+    TextCursor cursor(file.Data(), file.Data() + file.Size(), path);
+
+    Mesh mesh;
+    EdgeSet edgeSet;
+    std::vector<uint32_t> face;
+
+    // Indices start from 1, negative ones count back from the last vertex
+    auto readIndex = [&]() {
+        const int64_t index = cursor.Number<int64_t>();
+        cursor.SkipIndexSuffix();
+        const int64_t count = static_cast<int64_t>(mesh.VertexCount());
+        return CheckIndex(index < 0 ? count + index : index - 1, mesh.VertexCount(), path);
+    };
+
+    while (cursor.SkipBlank(true), !cursor.AtEnd())
+    {
+        const std::string keyword = cursor.Word();
+        if (keyword == "v")
+        {
+            const double x = cursor.Number<double>();
+            const double y = cursor.Number<double>();
+            const double z = cursor.Number<double>();
+            mesh.AddVertex(x, y, z);
+        }
+        else if (keyword == "f" || keyword == "l")
+        {
+            face.clear();
+            while (!cursor.AtLineEnd())
+            {
+                face.push_back(readIndex());
+            }
+            if (keyword == "f")
+            {
+                AddFace(mesh, edgeSet, face);
+            }
+            else
+            {
+                // Polyline, not closed
+                for (size_t i = 1; i < face.size(); i++)
+                {
+                    edgeSet.Add(mesh, face[i - 1], face[i]);
+                }
+            }
+        }
+        cursor.SkipLine();
+    }
+
+    if (mesh.edges.empty())
+    {
+        throw GrafikaException("Modelī nav nevienas šķautnes: " + path);
+    }
+    PrintSummary(mesh);
+    return mesh;
+}
+
+Mesh LoadPlyMesh(const std::string& path)
+{
+    core::MappedFile file(path);
+    const char* data = file.Data();
+    const char* end = data + file.Size();
+
+    // Header is short, read it line by line up to a line that is just
+    // end_header, so that the word in a comment does not end it
+    const char* headerEnd = nullptr;
+    std::string headerText;
+    for (const char* lineStart = data; lineStart != end && headerEnd == nullptr;)
+    {
+        const char* lineEnd = std::find(lineStart, end, '\n');
+        std::string headerLine(lineStart, lineEnd);
+        while (!headerLine.empty() && IsBlank(headerLine.back()))
+        {
+            headerLine.pop_back();
+        }
+        lineStart = lineEnd == end ? end : lineEnd + 1;
+        if (headerLine == "end_header")
+        {
+            headerEnd = lineStart;
+        }
+        else if (static_cast<size_t>(lineStart - data) > MAX_PLY_HEADER)
+        {
+            break;
+        }
+        headerText += headerLine + '\n';
+    }
+    if (file.Size() < 3 || memcmp(data, "ply", 3) != 0 || headerEnd == nullptr)
+    {
+        throw GrafikaException("Nekorekta PLY faila galvene: " + path);
+    }
+
+    PlyFormat format = PlyFormat::Ascii;
+    std::vector<PlyElement> elements;
+    std::istringstream header(headerText);
+    std::string line;
+    while (std::getline(header, line))
+    {
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        if (keyword == "format")
+        {
+            std::string name;
+            words >> name;
+            if (name == "ascii") format = PlyFormat::Ascii;
+            else if (name == "binary_little_endian") format = PlyFormat::LittleEndian;
+            else if (name == "binary_big_endian") format = PlyFormat::BigEndian;
+            else throw GrafikaException("Neatbalstīts PLY formāts '" + name + "' failā: " + path);
+        }
+        else if (keyword == "element")
+        {
+            PlyElement element;
+            if (!(words >> element.name >> element.count))
+            {
+                throw GrafikaException("Nekorekta PLY faila galvene: " + path);
+            }
+            elements.push_back(element);
+        }
+        else if (keyword == "property")
+        {
+            if (elements.empty())
+            {
+                throw GrafikaException("Nekorekta PLY faila galvene: " + path);
+            }
+            PlyProperty property;
+            std::string type;
+            words >> type;
+            property.isList = type == "list";
+            if (property.isList)
+            {
+                std::string countType;
+                words >> countType >> type;
+                property.countType = ParsePlyType(countType, path);
+            }
+            else
+            {
+                property.countType = PlyType::UInt8;
+            }
+            property.type = ParsePlyType(type, path);
+            words >> property.name;
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    Mesh mesh;
+    EdgeSet edgeSet;
+    std::vector<uint32_t> face;
+    uint64_t vertexCount = 0;
+    for (const auto& element : elements)
+    {
+        if (element.name == "vertex")
+        {
+            vertexCount = element.count;
+        }
+    }
+    if (vertexCount >= UINT32_MAX)
+    {
+        throw GrafikaException("Pārāk daudz virsotņu failā: " + path);
+    }
+
+    // Counts come from the file, they must fit in it before anything is reserved
+    uint64_t remaining = static_cast<uint64_t>(end - headerEnd);
+    for (const auto& element : elements)
+    {
+        const uint64_t size = MinElementSize(element, format);
+        if (element.count > remaining / size)
+        {
+            throw GrafikaException("PLY elementu skaits neatbilst faila izmēram: " + path);
+        }
+        remaining -= element.count * size;
+    }
+
+    PlyReader reader(headerEnd, end, format, path);
+    for (const auto& element : elements)
+    {
+        if (element.name == "vertex")
+        {
+            mesh.x.reserve(element.count);
+            mesh.y.reserve(element.count);
+            mesh.z.reserve(element.count);
+            for (uint64_t i = 0; i < element.count; i++)
+            {
+                reader.StartElement();
+                double coord[3] = {0, 0, 0};
+                for (const auto& property : element.properties)
+                {
+                    const int axis = property.name == "x" ? 0 : property.name == "y" ? 1 : property.name == "z" ? 2 : -1;
+                    if (axis >= 0 && property.isList == false)
+                    {
+                        coord[axis] = reader.Real(property.type);
+                    }
+                    else
+                    {
+                        reader.Skip(property);
+                    }
+                }
+                reader.FinishElement();
+                mesh.AddVertex(coord[0], coord[1], coord[2]);
+            }
+        }
+        else if (element.name == "face")
+        {
+            for (uint64_t i = 0; i < element.count; i++)
+            {
+                reader.StartElement();
+                for (const auto& property : element.properties)
+                {
+                    if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index"))
+                    {
+                        const int64_t count = reader.Integer(property.countType);
+                        face.clear();
+                        for (int64_t k = 0; k < count; k++)
+                        {
+                            face.push_back(CheckIndex(reader.Integer(property.type), vertexCount, path));
+                        }
+                        AddFace(mesh, edgeSet, face);
+                    }
+                    else
+                    {
+                        reader.Skip(property);
+                    }
+                }
+                reader.FinishElement();
+            }
+        }
+        else
+        {
+            for (uint64_t i = 0; i < element.count; i++)
+            {
+                reader.StartElement();
+                for (const auto& property : element.properties)
+                {
+                    reader.Skip(property);
+                }
+                reader.FinishElement();
+            }
+        }
+    }
+
+    if (mesh.edges.empty())
+    {
+        throw GrafikaException("Modelī nav nevienas šķautnes: " + path);
+    }
+    PrintSummary(mesh);
+    return mesh;
+}
+
+Mesh LoadMesh(const std::string& path)
+{
+    core::TraceZone zone("Load mesh");
+    const std::string ext = Extension(path);
+    if (ext == "obj")
+    {
+        return LoadObjMesh(path);
+    }
+    if (ext == "ply")
+    {
+        return LoadPlyMesh(path);
+    }
+    throw GrafikaException("Neatbalstīts modeļa faila paplašinājums: " + path);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+#include "Mesh.h"
+
+// Loads a wireframe from an OBJ or PLY file (chosen by extension). Faces are
+// not kept, their sides are turned into unique edges as the file is read.
+Mesh LoadMesh(const std::string& path);
+
+Mesh LoadObjMesh(const std::string& path);
+
+// Supports ascii, binary_little_endian and binary_big_endian PLY
+Mesh LoadPlyMesh(const std::string& path);
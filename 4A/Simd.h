@@ -0,0 +1,7 @@
+#pragma once
+
+// SSE2 is always there on x86-64, AVX only when the compiler targets it
+#if defined(__SSE2__) || defined(_M_X64)
+#define WIREFRAME_SIMD
+#include <immintrin.h>
+#endif
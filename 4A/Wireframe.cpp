@@ -0,0 +1,103 @@
+#include "Wireframe.h"
+
+#include "core/Trace.h"
+#include "LineRasterizer.h"
+
+namespace {
+    const double PI = acos(-1.0L);
+}
+
+Mesh DodecahedronMesh()
+{
+    // Calculate all dodecahedron vertices
+    Mesh mesh;
+    double fi = (1 + sqrt(5)) / 2;
+    for (int i = -1; i < 2; i+=2)
+    {
+        for (int j = -1; j < 2; j+=2)
+        {
+            mesh.AddVertex(0, i * fi, j * (1/fi));
+            mesh.AddVertex(i * (1/fi), 0, j * fi);
+            mesh.AddVertex(i * fi, j * (1/fi), 0);
+            for (int k = -1; k < 2; k+=2)
+            {
+                mesh.AddVertex(i, j, k);
+            }
+        }
+    }
+
+    const double expected = sqrt(5) - 1;
+    const uint32_t n = static_cast<uint32_t>(mesh.VertexCount());
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t j = i + 1; j < n; j++)
+        {
+            double dist = Vec4<double>::getDirection(mesh.x[i] - mesh.x[j], mesh.y[i] - mesh.y[j],
+                                                     mesh.z[i] - mesh.z[j]).length();
+            if (abs(expected - dist) < 0.0000001)
+            {
+                mesh.edges.emplace_back(i, j);
+            }
+        }
+    }
+
+    return mesh;
+}
+
+Mat4<double> RandomTransform(std::mt19937& generator)
+{
+    // Choosing random parameters
+    auto degDist = std::uniform_real_distribution<>(0.0L, PI);
+    auto scaleDist = std::uniform_real_distribution<>(0.2L, 0.4L);
+    auto numberDist = std::uniform_real_distribution<>(-1L, 1L);
+    auto shearingDist = std::uniform_real_distribution<>(0.5, 1.5);
+
+    // Drawn one by one, so that a seed gives the same transform with any
+    // argument evaluation order
+    double offset[3], angle[6], scale[3];
+    for (double& v : offset)
+        v = numberDist(generator);
+    for (int i = 0; i < 3; i++)
+        angle[i] = degDist(generator);
+    const double shearing = shearingDist(generator);
+    for (int i = 3; i < 6; i++)
+        angle[i] = degDist(generator);
+    for (double& v : scale)
+        v = scaleDist(generator);
+
+    using V4D = Vec4<double>;
+    constexpr auto initialPos = V4D::getPos(2, 2, 2);
+    constexpr auto cameraPos = V4D::getPos(-1, 1, 1);
+
+    auto camera = CameraLookAt(cameraPos, initialPos, V4D{0, 1, 0, 0});
+
+    // All factors are affine, so the chain is composed with 3x4 products
+    return Compose(camera,
+                   Mat4<double>::getTranslate(offset[0], offset[1], offset[2]),
+                   Mat4<double>::getTranslate(initialPos),
+                   Mat4<double>::getRoationX(angle[0]),
+                   Mat4<double>::getRoationY(angle[1]),
+                   Mat4<double>::getRoationZ(angle[2]),
+                   Mat4<double>::getXYShearing(shearing),
+                   Mat4<double>::getRoationX(angle[3]),
+                   Mat4<double>::getRoationY(angle[4]),
+                   Mat4<double>::getRoationZ(angle[5]),
+                   Mat4<double>::getScale(scale[0], scale[1], scale[2]));
+}
+
+cv::Mat DrawImage(const Mesh& mesh, Mat4<double> mat, bool perspective, unsigned threads)
+{
+    core::TraceZone zone("Draw image");
+    if (perspective)
+    {
+        mat = Mat4<double>::getPerspectiveProjection(1) * mat;
+    }
+
+    cv::Mat screen = cv::Mat::zeros({SCREEN_SIZE, SCREEN_SIZE}, CV_8U);
+
+    ClipVertices vertices;
+    TransformVertices(mesh, mat, vertices);
+    DrawEdges(screen, vertices, mesh.edges, threads);
+    return screen;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <random>
+
+#include <opencv2/opencv.hpp>
+
+#include "Matrix.h"
+#include "Mesh.h"
+
+// Side of the square image the wireframes are drawn to
+const int SCREEN_SIZE = 800;
+
+Mesh DodecahedronMesh();
+
+// Camera, placement and a chain of random rotations, shearing and scaling
+Mat4<double> RandomTransform(std::mt19937& generator);
+
+cv::Mat DrawImage(const Mesh& mesh, Mat4<double> mat, bool perspective, unsigned threads);
@@ -1,8 +1,10 @@
 #include <opencv2/opencv.hpp>
+#include "core/Trace.h"
 #include "core/Utility.h"
 
 cv::Mat equalizeHist(cv::Mat image)
 {
+    core::TraceZone zone("Equalize histogram");
     assert(image.type() == CV_8U);
 
     // Count pixels with each unique luminiscence value
@@ -68,7 +70,10 @@ int safe_main(int argc, char** argv)
     ch[0].copyTo(tmpChannel);
 
     // CV equalization for comparision
-    cv::equalizeHist(tmpChannel, ch[0]);
+    {
+        core::TraceZone zone("OpenCV equalize histogram");
+        cv::equalizeHist(tmpChannel, ch[0]);
+    }
     cv::Mat cvResult;
     cv::merge(ch, cvResult);
     cv::cvtColor(cvResult, cvResult, CV_YCrCb2BGR);
@@ -1,9 +1,12 @@
 #include <opencv2/opencv.hpp>
+#include "core/ThreadPool.h"
+#include "core/Trace.h"
 #include "core/Utility.h"
 #include <assert.h>
 
 cv::Mat applyFilterOnImage(cv::Mat image, cv::Mat filter)
 {
+    core::TraceZone zone("Apply filter");
     assert(image.type() == CV_8UC3);
     assert(filter.type() == CV_32F);
 
@@ -28,15 +31,20 @@ cv::Mat applyFilterOnImage(cv::Mat image, cv::Mat filter)
     image.convertTo(fimage, CV_32FC3);
     cv::split(fimage, layers);
 
-    // Apply filter to each channel
+    // Apply filter to each channel, channels are independent tasks
+    core::TaskGroup group;
     for (size_t i = 0; i < layers.size(); i++)
     {
-        cv::merge(std::vector<cv::Mat>{layers[i], cv::Mat::zeros(layers[i].size(), CV_32F)}, layers[i]);
-        cv::dft(layers[i], layers[i]);
-        cv::mulSpectrums(layers[i], filterIm, layers[i], 0);
-        cv::dft(layers[i], layers[i], cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT);
-        cv::normalize(layers[i], layers[i], 0, 255, CV_MINMAX);
+        group.Run([&layers, &filterIm, i]() {
+            core::TraceZone channelZone("Filter channel");
+            cv::merge(std::vector<cv::Mat>{layers[i], cv::Mat::zeros(layers[i].size(), CV_32F)}, layers[i]);
+            cv::dft(layers[i], layers[i]);
+            cv::mulSpectrums(layers[i], filterIm, layers[i], 0);
+            cv::dft(layers[i], layers[i], cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT);
+            cv::normalize(layers[i], layers[i], 0, 255, CV_MINMAX);
+        });
     }
+    group.Wait();
 
     // Merge channels
     cv::Mat res;
@@ -45,6 +53,7 @@ cv::Mat applyFilterOnImage(cv::Mat image, cv::Mat filter)
     cv::Mat shiftedOutput(res.size(), CV_8UC3);
 
     // Shift image
+    core::TraceZone shiftZone("Shift");
     int shiftX = filter.cols / 2;
     int shiftY = filter.rows / 2;
     for (int r = 0, tr = res.rows - shiftY; r < res.rows; r++, tr++)
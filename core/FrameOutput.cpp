@@ -0,0 +1,119 @@
+#include "FrameOutput.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <filesystem>
+
+#include "Trace.h"
+#include "Utility.h"
+
+namespace {
+    bool EndsWith(const std::string& str, const std::string& suffix)
+    {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+core::FrameWriter::FrameWriter(const std::string& outputArg, size_t reorderFramesArg)
+    : output(outputArg)
+    , raw(EndsWith(outputArg, ".raw"))
+    , reorderFrames(std::max<size_t>(reorderFramesArg, 1))
+{
+    if (raw)
+    {
+        stream.open(output, std::ios::binary);
+        if (!stream.is_open())
+        {
+            throw GrafikaException("Neizdevās atvērt izvades failu: " + output);
+        }
+    }
+    else
+    {
+        std::filesystem::create_directories(output);
+    }
+}
+
+core::FrameWriter::~FrameWriter() = default;
+
+void core::FrameWriter::Write(size_t index, const cv::Mat& frame)
+{
+    TraceZone zone("Write frame");
+    if (!raw)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "frame_%06zu.png", index);
+        const std::string path = (std::filesystem::path(output) / name).string();
+        if (!cv::imwrite(path, frame))
+        {
+            throw GrafikaException("Neizdevās saglabāt kadru: " + path);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [&]() { return failed || index < nextFrame + reorderFrames; });
+    if (failed)
+    {
+        throw GrafikaException("Izvades fails jau ir bojāts: " + output);
+    }
+    pending.emplace(index, frame);
+    const size_t firstFrame = nextFrame;
+    while (!pending.empty() && pending.begin()->first == nextFrame)
+    {
+        const cv::Mat& next = pending.begin()->second;
+        const auto rowBytes = static_cast<std::streamsize>(static_cast<size_t>(next.cols) * next.elemSize());
+        for (int y = 0; y < next.rows; y++)
+        {
+            stream.write(reinterpret_cast<const char*>(next.ptr(y)), rowBytes);
+        }
+        if (!stream)
+        {
+            failed = true;
+            written.notify_all();
+            throw GrafikaException("Neizdevās ierakstīt izvades failā: " + output);
+        }
+        pending.erase(pending.begin());
+        ++nextFrame;
+    }
+    if (nextFrame != firstFrame)
+    {
+        written.notify_all();
+    }
+}
+
+core::FrameQueue::FrameQueue(size_t capacityArg)
+    : capacity(capacityArg)
+{ }
+
+core::FrameQueue::~FrameQueue() = default;
+
+bool core::FrameQueue::Push(size_t index, cv::Mat frame)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [&]() { return closed || items.size() < capacity; });
+    if (closed)
+        return false;
+    items.emplace_back(index, std::move(frame));
+    notEmpty.notify_one();
+    return true;
+}
+
+bool core::FrameQueue::Pop(std::pair<size_t, cv::Mat>& item)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [&]() { return closed || !items.empty(); });
+    if (items.empty())
+        return false;
+    item = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+}
+
+void core::FrameQueue::Close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    notFull.notify_all();
+    notEmpty.notify_all();
+}
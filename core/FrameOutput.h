@@ -0,0 +1,51 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace core{
+    // Writes numbered frames to a directory of frame_%06zu.png files, or to a
+    // single .raw stream of the frame pixels in order. Frames of a raw stream
+    // that arrive early are held back until the ones before them are in, Write
+    // blocks while its frame is reorderFrames or more ahead of the next one.
+    class FrameWriter{
+        std::string output;
+        bool raw;
+        std::ofstream stream;
+        std::mutex mutex;
+        std::condition_variable written;
+        std::map<size_t, cv::Mat> pending;
+        size_t nextFrame = 0;
+        size_t reorderFrames;
+        bool failed = false;
+    public:
+        explicit FrameWriter(const std::string& output, size_t reorderFrames = 64);
+        ~FrameWriter();
+
+        // Safe to call from several threads
+        void Write(size_t index, const cv::Mat& frame);
+    };
+
+    // Bounded queue between frame producers and an encoder thread
+    class FrameQueue{
+        std::mutex mutex;
+        std::condition_variable notFull, notEmpty;
+        std::deque<std::pair<size_t, cv::Mat>> items;
+        size_t capacity;
+        bool closed = false;
+    public:
+        explicit FrameQueue(size_t capacity);
+        ~FrameQueue();
+
+        // Blocks while the queue is full, false once the queue is closed
+        bool Push(size_t index, cv::Mat frame);
+        // Blocks until a frame is available, false once closed and drained
+        bool Pop(std::pair<size_t, cv::Mat>& item);
+        void Close();
+    };
+}
@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Utility.h"
+
+#ifdef _WIN32
+
+core::MappedFile::MappedFile(const std::string& path)
+{
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw GrafikaException("Failed to open file " + path);
+    }
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length))
+    {
+        CloseHandle(file);
+        throw GrafikaException("Failed to get size of file " + path);
+    }
+    size = static_cast<size_t>(length.QuadPart);
+
+    // Empty files can not be mapped
+    if (size == 0)
+        return;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        throw GrafikaException("Failed to map file " + path);
+    }
+
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw GrafikaException("Failed to map file " + path);
+    }
+}
+
+core::MappedFile::~MappedFile()
+{
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    CloseHandle(file);
+}
+
+#else
+
+core::MappedFile::MappedFile(const std::string& path)
+{
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw GrafikaException("Failed to open file " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw GrafikaException("Failed to get size of file " + path);
+    }
+    size = static_cast<size_t>(info.st_size);
+
+    // Empty files can not be mapped
+    if (size == 0)
+        return;
+
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        close(fd);
+        throw GrafikaException("Failed to map file " + path);
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(addr);
+}
+
+core::MappedFile::~MappedFile()
+{
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), size);
+    close(fd);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+namespace core{
+    // Read only memory mapping of a whole file
+    class MappedFile {
+        const char* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        void* file = nullptr;
+        void* mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* Data() const
+        {
+            return data;
+        }
+
+        size_t Size() const
+        {
+            return size;
+        }
+    };
+}
@@ -0,0 +1,292 @@
+#include "ThreadPool.h"
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+#include "Trace.h"
+#include "Utility.h"
+
+namespace {
+    // 0 when not set
+    std::atomic<unsigned> threadOverride{0};
+    std::atomic<bool> globalStarted{false};
+
+    // Pool and queue of the worker running on this thread
+    thread_local const core::ThreadPool* currentPool = nullptr;
+    thread_local size_t currentQueue = 0;
+
+    unsigned StartGlobal()
+    {
+        globalStarted = true;
+        return core::ThreadCount();
+    }
+}
+
+unsigned core::ThreadCount()
+{
+    const unsigned threads = threadOverride;
+    return threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void core::SetThreadCount(unsigned threads)
+{
+    if (threads == 0)
+    {
+        throw GrafikaException("Thread count must be positive");
+    }
+    if (globalStarted && threads != ThreadCount())
+    {
+        throw GrafikaException("Thread count can not change after the thread pool started");
+    }
+    threadOverride = threads;
+    // cv::dft and other OpenCV calls in the tools run on OpenCV's own pool
+    cv::setNumThreads(static_cast<int>(threads));
+}
+
+void core::TakeThreadsOption(int& argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") != 0)
+        {
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            throw GrafikaException("Missing value for --threads");
+        }
+        const int threads = std::atoi(argv[i + 1]);
+        if (threads <= 0)
+        {
+            throw GrafikaException("Thread count must be positive");
+        }
+        SetThreadCount(static_cast<unsigned>(threads));
+
+        std::copy(argv + i + 2, argv + argc + 1, argv + i);
+        argc -= 2;
+        i--;
+    }
+}
+
+core::ThreadPool::ThreadPool(unsigned threads)
+{
+    threads = std::max(threads, 1u);
+    for (unsigned q = 0; q < threads; q++)
+    {
+        queues.emplace_back(new Queue);
+    }
+    for (size_t q = 1; q < threads; q++)
+    {
+        workers.emplace_back(&ThreadPool::Work, this, q);
+    }
+}
+
+core::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+core::ThreadPool& core::ThreadPool::Global()
+{
+    static ThreadPool pool(StartGlobal());
+    return pool;
+}
+
+unsigned core::ThreadPool::Threads() const
+{
+    return static_cast<unsigned>(queues.size());
+}
+
+void core::ThreadPool::Submit(TaskGroup& group, std::function<void()> func)
+{
+    Queue& queue = *queues[currentPool == this ? currentQueue : 0];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({std::move(func), &group});
+    }
+    queued++;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool core::ThreadPool::Pop(size_t index, bool back, Task& task)
+{
+    Queue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    if (back)
+    {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+    }
+    else
+    {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+    }
+    return true;
+}
+
+bool core::ThreadPool::RunOne()
+{
+    // Newest own task first, it is the most likely to be in cache, then the
+    // oldest of the shared queue and the other workers
+    const size_t own = currentPool == this ? currentQueue : 0;
+    Task task;
+    bool found = own != 0 && Pop(own, true, task);
+    for (size_t k = 0; !found && k < queues.size(); k++)
+    {
+        const size_t index = (own + k) % queues.size();
+        found = (index != own || own == 0) && Pop(index, false, task);
+    }
+    if (!found)
+    {
+        return false;
+    }
+    queued--;
+
+    std::exception_ptr error;
+    try
+    {
+        task.func();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    task.group->Finished(error);
+    return true;
+}
+
+void core::ThreadPool::Work(size_t queue)
+{
+    currentPool = this;
+    currentQueue = queue;
+    SetTraceThreadName("Pool worker");
+    while (true)
+    {
+        if (RunOne())
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stop || queued > 0; });
+        if (stop && queued == 0)
+        {
+            return;
+        }
+    }
+}
+
+void core::ThreadPool::WaitUntil(const std::function<bool()>& done)
+{
+    while (!done())
+    {
+        if (RunOne())
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&]() { return done() || queued > 0; });
+    }
+}
+
+void core::ThreadPool::Notify()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+}
+
+core::TaskGroup::TaskGroup(ThreadPool& poolArg)
+    : pool(poolArg)
+{ }
+
+core::TaskGroup::~TaskGroup()
+{
+    pool.WaitUntil([this]() { return pending == 0; });
+}
+
+void core::TaskGroup::Run(std::function<void()> func)
+{
+    pending++;
+    pool.Submit(*this, std::move(func));
+}
+
+void core::TaskGroup::Finished(std::exception_ptr taskError)
+{
+    if (taskError)
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+            error = taskError;
+    }
+    // The group may be gone as soon as pending reaches 0
+    ThreadPool& groupPool = pool;
+    if (--pending == 0)
+    {
+        groupPool.Notify();
+    }
+}
+
+void core::TaskGroup::Wait()
+{
+    pool.WaitUntil([this]() { return pending == 0; });
+    std::exception_ptr taskError;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        std::swap(taskError, error);
+    }
+    if (taskError)
+    {
+        std::rethrow_exception(taskError);
+    }
+}
+
+void core::ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& func)
+{
+    grain = std::max<size_t>(grain, 1);
+    if (end <= begin)
+    {
+        return;
+    }
+    if (ThreadPool::Global().Threads() == 1 || end - begin <= grain)
+    {
+        for (size_t first = begin; first < end; first += std::min(grain, end - first))
+        {
+            func(first, first + std::min(grain, end - first));
+        }
+        return;
+    }
+
+    // Halves are split off as tasks for thieves while this thread goes on
+    // with the first half. Declared before the group, which waits for them.
+    std::function<void(size_t, size_t)> split;
+    TaskGroup group;
+    split = [&](size_t first, size_t last) {
+        while (last - first > grain)
+        {
+            const size_t middle = first + (last - first + grain - 1) / grain / 2 * grain;
+            group.Run([&split, middle, last]() { split(middle, last); });
+            last = middle;
+        }
+        func(first, last);
+    };
+    split(begin, end);
+    group.Wait();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core{
+    // Threads for parallel work: the global --threads option, otherwise the
+    // hardware concurrency
+    unsigned ThreadCount();
+    // Only before the first parallel work, the shared pool does not resize.
+    // Also limits the threads of OpenCV.
+    void SetThreadCount(unsigned threads);
+    // Removes "--threads T" from the arguments and applies it, called by
+    // CatchExceptions for every tool
+    void TakeThreadsOption(int& argc, char** argv);
+
+    class TaskGroup;
+
+    // Work stealing pool shared by all tools. Every worker has its own deque,
+    // it pushes and pops its tasks at the back while idle workers steal from
+    // the front of the others. Threads outside the pool submit to a shared
+    // queue. Threads waiting for a TaskGroup run queued tasks meanwhile, so
+    // parallel loops can nest.
+    class ThreadPool{
+        struct Task{
+            std::function<void()> func;
+            TaskGroup* group;
+        };
+        struct Queue{
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        // Shared queue first, then one per worker
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        std::atomic<size_t> queued{0};
+        bool stop = false;
+
+        bool Pop(size_t queue, bool back, Task& task);
+        bool RunOne();
+        void Work(size_t queue);
+    public:
+        // threads - 1 workers, the thread waiting for the work is the last one
+        explicit ThreadPool(unsigned threads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Started on first use with ThreadCount() threads
+        static ThreadPool& Global();
+
+        unsigned Threads() const;
+        void Submit(TaskGroup& group, std::function<void()> func);
+        // Runs queued tasks until done() or there is nothing to run, then
+        // sleeps until more tasks arrive or Notify()
+        void WaitUntil(const std::function<bool()>& done);
+        void Notify();
+    };
+
+    // Tasks that can be waited for together. The first exception thrown by a
+    // task is rethrown by Wait.
+    class TaskGroup{
+        friend class ThreadPool;
+
+        ThreadPool& pool;
+        std::atomic<size_t> pending{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        void Finished(std::exception_ptr taskError);
+    public:
+        explicit TaskGroup(ThreadPool& pool = ThreadPool::Global());
+        // Waits for the remaining tasks, drops their exceptions
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void Run(std::function<void()> func);
+        void Wait();
+    };
+
+    // Calls func(first, last) for the pieces of [begin; end) split at multiples
+    // of grain from begin. The pieces do not depend on the thread count.
+    void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& func);
+}
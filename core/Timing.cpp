@@ -0,0 +1,273 @@
+#include "Timing.h"
+
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include "Utility.h"
+
+namespace {
+    const double MISSING = std::numeric_limits<double>::quiet_NaN();
+    // Histogram buckets end at 2^k milliseconds, the last one is open
+    const int HISTOGRAM_FIRST_POWER = -4;
+    const int HISTOGRAM_BUCKETS = 12;
+
+    struct Statistics{
+        size_t count = 0;
+        double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+        size_t histogram[HISTOGRAM_BUCKETS] = {};
+    };
+
+    bool EndsWith(const std::string& str, const std::string& suffix)
+    {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    void Accumulate(std::vector<double>& frame, size_t section, double milliseconds)
+    {
+        // Sections added after the frame started
+        frame.resize(std::max(frame.size(), section + 1), MISSING);
+        frame[section] = std::isnan(frame[section]) ? milliseconds : frame[section] + milliseconds;
+    }
+
+    // Nearest rank percentile of sorted values
+    double Percentile(const std::vector<double>& sorted, double percent)
+    {
+        const size_t rank = static_cast<size_t>(ceil(percent / 100 * static_cast<double>(sorted.size())));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+
+    Statistics Summarize(const std::deque<std::vector<double>>& frames, size_t section)
+    {
+        std::vector<double> values;
+        for (const auto& frame : frames)
+        {
+            if (section < frame.size() && !std::isnan(frame[section]))
+            {
+                values.push_back(frame[section]);
+            }
+        }
+
+        Statistics stats;
+        if (values.empty())
+        {
+            return stats;
+        }
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (double value : values)
+        {
+            sum += value;
+            int bucket = 0;
+            while (bucket + 1 < HISTOGRAM_BUCKETS && value >= ldexp(1.0, HISTOGRAM_FIRST_POWER + bucket))
+            {
+                bucket++;
+            }
+            stats.histogram[bucket]++;
+        }
+        stats.count = values.size();
+        stats.mean = sum / static_cast<double>(values.size());
+        stats.p50 = Percentile(values, 50);
+        stats.p90 = Percentile(values, 90);
+        stats.p99 = Percentile(values, 99);
+        stats.max = values.back();
+        return stats;
+    }
+}
+
+core::FrameTimings::FrameTimings(size_t maxFramesArg)
+    : maxFrames(std::max<size_t>(maxFramesArg, 1))
+{ }
+
+core::FrameTimings::~FrameTimings() = default;
+
+size_t core::FrameTimings::Section(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto found = std::find(names.begin(), names.end(), name);
+    if (found != names.end())
+    {
+        return static_cast<size_t>(found - names.begin());
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+size_t core::FrameTimings::NextFrame()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frames.size() == maxFrames)
+    {
+        // The oldest row is reused
+        frames.push_back(std::move(frames.front()));
+        frames.pop_front();
+        frames.back().assign(names.size(), MISSING);
+        ++firstFrame;
+    }
+    else
+    {
+        frames.emplace_back(names.size(), MISSING);
+    }
+    return firstFrame + frames.size() - 1;
+}
+
+size_t core::FrameTimings::CurrentFrame() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return frames.empty() ? 0 : firstFrame + frames.size() - 1;
+}
+
+void core::FrameTimings::Add(size_t section, double milliseconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frames.empty())
+    {
+        return;
+    }
+    Accumulate(frames.back(), section, milliseconds);
+}
+
+void core::FrameTimings::Add(size_t frameIndex, size_t section, double milliseconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (frameIndex < firstFrame || frameIndex - firstFrame >= frames.size())
+    {
+        return;
+    }
+    Accumulate(frames[frameIndex - firstFrame], section, milliseconds);
+}
+
+void core::FrameTimings::PrintSummary(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t width = 8;
+    for (const std::string& name : names)
+    {
+        width = std::max(width, name.size());
+    }
+
+    if (firstFrame > 0)
+    {
+        out << "last ";
+    }
+    out << frames.size() << " frames, milliseconds\n"
+        << std::left << std::setw(static_cast<int>(width)) << "section" << std::right
+        << std::setw(12) << "mean" << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "max"
+        << "\n" << std::fixed << std::setprecision(3);
+    for (size_t s = 0; s < names.size(); s++)
+    {
+        const Statistics stats = Summarize(frames, s);
+        out << std::left << std::setw(static_cast<int>(width)) << names[s] << std::right
+            << " " << std::setw(11) << stats.mean << " " << std::setw(11) << stats.p50 << " " << std::setw(11)
+            << stats.p99 << " " << std::setw(11) << stats.max << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
+
+void core::FrameTimings::Write(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        throw GrafikaException("Failed to write " + path);
+    }
+
+    if (!EndsWith(path, ".json"))
+    {
+        out << "index";
+        for (const std::string& name : names)
+        {
+            out << "," << name;
+        }
+        out << "\n";
+        for (size_t f = 0; f < frames.size(); f++)
+        {
+            out << firstFrame + f;
+            for (size_t s = 0; s < names.size(); s++)
+            {
+                out << ",";
+                if (s < frames[f].size() && !std::isnan(frames[f][s]))
+                {
+                    out << frames[f][s];
+                }
+            }
+            out << "\n";
+        }
+    }
+    else
+    {
+        out << "{\n"
+            << "  \"frames\": " << frames.size() << ",\n"
+            << "  \"first_frame\": " << firstFrame << ",\n"
+            << "  \"histogram_upper_ms\": [";
+        for (int b = 0; b + 1 < HISTOGRAM_BUCKETS; b++)
+        {
+            out << (b ? ", " : "") << ldexp(1.0, HISTOGRAM_FIRST_POWER + b);
+        }
+        out << "],\n"
+            << "  \"sections\": [\n";
+        for (size_t s = 0; s < names.size(); s++)
+        {
+            const Statistics stats = Summarize(frames, s);
+            out << "    {\"name\": \"" << names[s] << "\""
+                << ", \"count\": " << stats.count
+                << ", \"mean_ms\": " << stats.mean
+                << ", \"p50_ms\": " << stats.p50
+                << ", \"p90_ms\": " << stats.p90
+                << ", \"p99_ms\": " << stats.p99
+                << ", \"max_ms\": " << stats.max
+                << ", \"histogram\": [";
+            for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+            {
+                out << (b ? ", " : "") << stats.histogram[b];
+            }
+            out << "]}" << (s + 1 < names.size() ? "," : "") << "\n";
+        }
+        out << "  ],\n"
+            << "  \"frame_ms\": [\n";
+        for (size_t f = 0; f < frames.size(); f++)
+        {
+            out << "    [";
+            for (size_t s = 0; s < names.size(); s++)
+            {
+                out << (s ? ", " : "");
+                if (s < frames[f].size() && !std::isnan(frames[f][s]))
+                    out << frames[f][s];
+                else
+                    out << "null";
+            }
+            out << "]" << (f + 1 < frames.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n"
+            << "}\n";
+    }
+
+    if (!out)
+    {
+        throw GrafikaException("Failed to write " + path);
+    }
+}
+
+core::ScopeTimer::ScopeTimer(FrameTimings& timingsArg, size_t sectionArg)
+    : timings(timingsArg)
+    , section(sectionArg)
+    , start(std::chrono::steady_clock::now())
+{ }
+
+core::ScopeTimer::~ScopeTimer()
+{
+    Stop();
+}
+
+void core::ScopeTimer::Stop()
+{
+    if (running)
+    {
+        timings.Add(section, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        running = false;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace core{
+    // Milliseconds spent in named sections of each frame. Sections can be
+    // timed from any thread; times of one section within a frame add up, a
+    // section that did not run in a frame is NaN and left out of statistics.
+    // Only the last maxFrames frames are kept, so memory stays bounded however
+    // long a tool runs; statistics and output cover those.
+    class FrameTimings{
+        mutable std::mutex mutex;
+        std::vector<std::string> names;
+        // One row per kept frame, one column per section
+        std::deque<std::vector<double>> frames;
+        // Index of frames.front()
+        size_t firstFrame = 0;
+        size_t maxFrames;
+    public:
+        explicit FrameTimings(size_t maxFrames = 1 << 16);
+        ~FrameTimings();
+
+        FrameTimings(const FrameTimings&) = delete;
+        FrameTimings& operator=(const FrameTimings&) = delete;
+
+        // Index of the section, added on first use
+        size_t Section(const std::string& name);
+        // Starts a new frame and returns its index
+        size_t NextFrame();
+        size_t CurrentFrame() const;
+
+        // Adds to the current frame, ignored before the first frame
+        void Add(size_t section, double milliseconds);
+        // Adds to an earlier frame, for results that arrive late. Ignored if
+        // the frame is no longer kept.
+        void Add(size_t frame, size_t section, double milliseconds);
+
+        // Mean, p50, p99 and maximum of each section
+        void PrintSummary(std::ostream& out) const;
+        // Every frame as CSV, or statistics, histograms and frames as JSON
+        // when path ends with .json
+        void Write(const std::string& path) const;
+    };
+
+    // Adds the time until the end of the scope to a section of the current
+    // frame
+    class ScopeTimer{
+        FrameTimings& timings;
+        size_t section;
+        std::chrono::steady_clock::time_point start;
+        bool running = true;
+    public:
+        ScopeTimer(FrameTimings& timings, size_t section);
+        ~ScopeTimer();
+
+        // Ends the section before the end of the scope
+        void Stop();
+
+        ScopeTimer(const ScopeTimer&) = delete;
+        ScopeTimer& operator=(const ScopeTimer&) = delete;
+    };
+}
@@ -0,0 +1,179 @@
+#include "Trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Utility.h"
+
+namespace {
+    const char* TRACE_VARIABLE = "GRAFIKA_TRACE";
+    const size_t CHUNK_EVENTS = 4096;
+
+    struct Event{
+        const char* name;
+        double start, duration;
+    };
+
+    // Written only by the owning thread, events are published by count so
+    // FlushTrace can read them while the thread goes on
+    struct Chunk{
+        Event events[CHUNK_EVENTS];
+        std::atomic<size_t> count{0};
+        std::atomic<Chunk*> next{nullptr};
+    };
+
+    struct ThreadBuffer{
+        unsigned id = 0;
+        std::atomic<const char*> name{nullptr};
+        Chunk first;
+        Chunk* last = &first;
+    };
+
+    // Buffers stay until the end of the program, after their threads exit
+    struct Registry{
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+
+    Registry& GetRegistry()
+    {
+        // Never destroyed, pool threads may still record during exit
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    // Unset or empty variable turns tracing off
+    const char* TracePath()
+    {
+        static const char* path = getenv(TRACE_VARIABLE);
+        return path != nullptr && *path != '\0' ? path : nullptr;
+    }
+
+    double Now()
+    {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+        if (threadBuffer == nullptr)
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.buffers.emplace_back(new ThreadBuffer);
+            threadBuffer = registry.buffers.back().get();
+            threadBuffer->id = static_cast<unsigned>(registry.buffers.size());
+        }
+        return *threadBuffer;
+    }
+
+    void Record(const char* name, double start, double duration)
+    {
+        ThreadBuffer& buffer = GetThreadBuffer();
+        Chunk* chunk = buffer.last;
+        size_t n = chunk->count.load(std::memory_order_relaxed);
+        if (n == CHUNK_EVENTS)
+        {
+            Chunk* fresh = new Chunk;
+            chunk->next.store(fresh, std::memory_order_release);
+            buffer.last = chunk = fresh;
+            n = 0;
+        }
+        chunk->events[n] = {name, start, duration};
+        chunk->count.store(n + 1, std::memory_order_release);
+    }
+
+    void WriteString(std::ostream& out, const char* str)
+    {
+        out << '"';
+        for (; *str; str++)
+        {
+            if (*str == '"' || *str == '\\')
+                out << '\\';
+            out << *str;
+        }
+        out << '"';
+    }
+}
+
+bool core::TraceEnabled()
+{
+    return TracePath() != nullptr;
+}
+
+void core::SetTraceThreadName(const char* name)
+{
+    if (TraceEnabled())
+    {
+        GetThreadBuffer().name = name;
+    }
+}
+
+void core::FlushTrace()
+{
+    if (!TraceEnabled())
+    {
+        return;
+    }
+
+    std::ofstream out(TracePath());
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out.precision(3);
+    out << std::fixed;
+    bool firstEvent = true;
+
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers)
+    {
+        if (const char* name = buffer->name.load())
+        {
+            out << (firstEvent ? "" : ",\n") << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": "
+                << buffer->id << ", \"args\": {\"name\": ";
+            WriteString(out, name);
+            out << "}}";
+            firstEvent = false;
+        }
+        for (const Chunk* chunk = &buffer->first; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            const size_t n = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < n; i++)
+            {
+                const Event& event = chunk->events[i];
+                out << (firstEvent ? "" : ",\n") << "{\"ph\": \"X\", \"name\": ";
+                WriteString(out, event.name);
+                out << ", \"pid\": 1, \"tid\": " << buffer->id << ", \"ts\": " << event.start
+                    << ", \"dur\": " << event.duration << "}";
+                firstEvent = false;
+            }
+        }
+    }
+    out << "\n]}\n";
+
+    if (!out)
+    {
+        throw GrafikaException(std::string("Failed to write trace ") + TracePath());
+    }
+}
+
+core::TraceZone::TraceZone(const char* nameArg)
+    : name(nameArg)
+    , start(TraceEnabled() ? Now() : -1)
+{ }
+
+core::TraceZone::~TraceZone()
+{
+    if (start >= 0)
+    {
+        Record(name, start, Now() - start);
+    }
+}
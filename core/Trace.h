@@ -0,0 +1,32 @@
+#pragma once
+
+namespace core{
+    // Chrome / Perfetto trace of the time spent in zones. Recording is on
+    // when the GRAFIKA_TRACE environment variable names an output file, the
+    // trace is written there by FlushTrace, which CatchExceptions calls when
+    // the tool ends. Every thread records into its own buffer without locks.
+    //
+    //     {
+    //         core::TraceZone zone("Parse scene");
+    //         ...
+    //     }
+    bool TraceEnabled();
+    // Names the calling thread in the trace, name must outlive the program
+    void SetTraceThreadName(const char* name);
+    // Writes everything recorded so far, as trace event JSON
+    void FlushTrace();
+
+    // Records the time from construction to destruction. name must be a
+    // string literal or otherwise outlive the program.
+    class TraceZone{
+        const char* name;
+        // Microseconds since the trace started, negative when not tracing
+        double start;
+    public:
+        explicit TraceZone(const char* name);
+        ~TraceZone();
+
+        TraceZone(const TraceZone&) = delete;
+        TraceZone& operator=(const TraceZone&) = delete;
+    };
+}
@@ -1,23 +1,45 @@
 #include "Utility.h"
 
+#include "ThreadPool.h"
+#include "Trace.h"
+
+namespace {
+    int Run(MainFunc func, int argc, char** argv)
+    {
+        try {
+            core::TakeThreadsOption(argc, argv);
+            func(argc, argv);
+            return 0;
+        } catch(const GrafikaException& e) {
+            std::cout << "Execution failed with the following error:" << std::endl;
+            std::cout << e.GetMessage() << std::endl;
+            return -1;
+        } catch(const std::exception& e) {
+            std::cout << "Unexpected exception:" << std::endl;
+            std::cout << e.what() << std::endl;
+            return -1;
+        }
+    }
+}
+
 int core::CatchExceptions(MainFunc func, int argc, char** argv)
 {
+    SetTraceThreadName("main");
+    const int result = Run(func, argc, argv);
+
+    // Also after a failure, the trace shows where it happened
     try {
-        func(argc, argv);
-        return 0;
-    } catch(const GrafikaException& e) {
-        std::cout << "Execution failed with the following error:" << std::endl;
-        std::cout << e.GetMessage() << std::endl;
-        return -1;
+        FlushTrace();
     } catch(const std::exception& e) {
-        std::cout << "Unexpected exception:" << std::endl;
         std::cout << e.what() << std::endl;
         return -1;
     }
+    return result;
 }
 
 cv::Mat core::ReadImage(int argc, char** argv, int flags, int argpos)
 {
+    TraceZone zone("Read image");
     if (argc <= argpos)
     {
         std::ostringstream oss;
@@ -39,6 +61,7 @@ cv::Mat core::ReadImage(int argc, char** argv, int flags, int argpos)
 
 std::string core::ReadFile(const std::string path)
 {
+    TraceZone zone("Read file");
 	std::ifstream stream(path, std::ios::in);
 	if(stream.is_open()){
         stream.seekg(0, stream.end);
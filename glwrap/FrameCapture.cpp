@@ -0,0 +1,150 @@
+#include "FrameCapture.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "core/Trace.h"
+#include "core/Utility.h"
+
+namespace {
+    // Frames read back but not yet encoded
+    const size_t QUEUE_FRAMES = 8;
+}
+
+glwrap::FrameCapture::FrameCapture(int widthArg, int heightArg, const std::string& output, size_t ring)
+    : width(widthArg)
+    , height(heightArg)
+    , buffers(std::max<size_t>(ring, 1), 0)
+    , fences(buffers.size(), nullptr)
+    , writer(output)
+    , queue(QUEUE_FRAMES)
+{
+    const auto frameBytes = static_cast<GLsizeiptr>(3 * static_cast<size_t>(width) * static_cast<size_t>(height));
+    glGenBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+    for (GLuint buffer : buffers)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    encoder = std::thread([this]() {
+        core::SetTraceThreadName("Encoder");
+        try
+        {
+            std::pair<size_t, cv::Mat> item;
+            while (queue.Pop(item))
+            {
+                writer.Write(item.first, item.second);
+            }
+        }
+        catch (...)
+        {
+            Fail();
+        }
+    });
+}
+
+glwrap::FrameCapture::~FrameCapture()
+{
+    queue.Close();
+    if (encoder.joinable())
+    {
+        encoder.join();
+    }
+    for (GLsync fence : fences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+}
+
+void glwrap::FrameCapture::Fail()
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (!error)
+        error = std::current_exception();
+    queue.Close();
+}
+
+void glwrap::FrameCapture::RethrowError()
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (error)
+        std::rethrow_exception(error);
+}
+
+bool glwrap::FrameCapture::Deliver(bool wait)
+{
+    const size_t slot = delivered % buffers.size();
+    GLsync& fence = fences[slot];
+    const GLenum status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                           wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+    if (status == GL_WAIT_FAILED)
+        throw GrafikaException("Failed to wait for frame readback");
+    glDeleteSync(fence);
+    fence = nullptr;
+    core::TraceZone zone("Read back frame");
+
+    // Rows are read bottom up
+    cv::Mat frame(height, width, CV_8UC3);
+    const size_t rowBytes = 3 * static_cast<size_t>(width);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+    const auto* pixels = static_cast<const unsigned char*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(rowBytes * static_cast<size_t>(height)),
+                         GL_MAP_READ_BIT));
+    if (pixels == nullptr)
+        throw GrafikaException("Failed to map frame readback buffer");
+    for (int y = 0; y < height; y++)
+    {
+        memcpy(frame.ptr(y), pixels + rowBytes * static_cast<size_t>(height - 1 - y), rowBytes);
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!queue.Push(delivered, std::move(frame)))
+        RethrowError();
+    ++delivered;
+    return true;
+}
+
+void glwrap::FrameCapture::Capture()
+{
+    core::TraceZone zone("Capture frame");
+    RethrowError();
+    if (captured - delivered == buffers.size())
+    {
+        Deliver(true);
+    }
+
+    const size_t slot = captured % buffers.size();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++captured;
+
+    // Older frames that are already done leave the ring early
+    while (delivered + 1 < captured && Deliver(false))
+    { }
+}
+
+void glwrap::FrameCapture::Finish()
+{
+    while (delivered < captured)
+    {
+        Deliver(true);
+    }
+    queue.Close();
+    if (encoder.joinable())
+    {
+        encoder.join();
+    }
+    RethrowError();
+}
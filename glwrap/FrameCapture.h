@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/FrameOutput.h"
+
+namespace glwrap{
+    // Captures the bound framebuffer into a ring of pixel buffer objects.
+    // glReadPixels only queues a copy on the GPU; a buffer is mapped once its
+    // fence has passed, usually a few frames later, and the frame is written
+    // by core::FrameWriter on an encoder thread. The render loop only waits
+    // when every buffer is still in flight or the encoder is behind.
+    class FrameCapture {
+        int width, height;
+        std::vector<GLuint> buffers;
+        std::vector<GLsync> fences;
+        size_t captured = 0, delivered = 0;
+
+        core::FrameWriter writer;
+        core::FrameQueue queue;
+        std::thread encoder;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        // Maps the oldest buffer and queues its frame, wait allows blocking
+        // on its fence. False if the frame was not ready.
+        bool Deliver(bool wait);
+        void Fail();
+        void RethrowError();
+    public:
+        // Output as for core::FrameWriter: a directory or a .raw file
+        FrameCapture(int width, int height, const std::string& output, size_t ring = 3);
+        ~FrameCapture();
+
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        // Starts reading the current frame
+        void Capture();
+        // Writes all captured frames, rethrows encoder errors
+        void Finish();
+    };
+}
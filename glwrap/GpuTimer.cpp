@@ -0,0 +1,105 @@
+#include "GpuTimer.h"
+
+#include "core/Utility.h"
+
+namespace {
+    // Longer results are driver errors, llvmpipe measures its first query
+    // from time zero
+    const GLuint64 MAX_NANOSECONDS = 1000000000;
+}
+
+glwrap::GpuTimer::GpuTimer(core::FrameTimings& timingsArg)
+    : timings(timingsArg)
+{ }
+
+glwrap::GpuTimer::~GpuTimer()
+{
+    for (const Pending& query : pending)
+    {
+        freeQueries.push_back(query.query);
+    }
+    if (!freeQueries.empty())
+    {
+        glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+    }
+}
+
+void glwrap::GpuTimer::Begin(size_t section)
+{
+    if (active)
+    {
+        throw GrafikaException("GPU timer sections can not overlap");
+    }
+
+    GLuint query;
+    if (freeQueries.empty())
+    {
+        glGenQueries(1, &query);
+    }
+    else
+    {
+        query = freeQueries.back();
+        freeQueries.pop_back();
+    }
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    pending.push_back({query, timings.CurrentFrame(), section});
+    active = true;
+}
+
+void glwrap::GpuTimer::End()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    active = false;
+}
+
+void glwrap::GpuTimer::Read(const Pending& query)
+{
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query.query, GL_QUERY_RESULT, &nanoseconds);
+    if (nanoseconds < MAX_NANOSECONDS)
+    {
+        timings.Add(query.frame, query.section, static_cast<double>(nanoseconds) * 1e-6);
+    }
+    freeQueries.push_back(query.query);
+}
+
+void glwrap::GpuTimer::Collect()
+{
+    // Queries finish in the order they were issued
+    const size_t ended = pending.size() - (active ? 1 : 0);
+    for (size_t i = 0; i < ended; i++)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(pending.front().query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+        {
+            break;
+        }
+        Read(pending.front());
+        pending.pop_front();
+    }
+}
+
+void glwrap::GpuTimer::Finish()
+{
+    if (active)
+    {
+        End();
+    }
+    while (!pending.empty())
+    {
+        Read(pending.front());
+        pending.pop_front();
+    }
+}
+
+glwrap::GpuScope::GpuScope(GpuTimer& timerArg, size_t section)
+    : timer(timerArg)
+{
+    timer.Begin(section);
+}
+
+glwrap::GpuScope::~GpuScope()
+{
+    timer.End();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <deque>
+#include <vector>
+
+#include <core/Timing.h>
+
+namespace glwrap{
+    // GL_TIME_ELAPSED queries around sections of a frame. Results are read
+    // only once available, usually a frame or two later, and added to the
+    // frame that issued them, so the CPU never waits for the GPU. Elapsed
+    // time queries can not nest, so timed sections must not overlap.
+    //
+    //     {
+    //         glwrap::GpuScope scope(gpuTimer, drawSection);
+    //         ... draw ...
+    //     }
+    //     gpuTimer.Collect();
+    class GpuTimer {
+        struct Pending{
+            GLuint query;
+            size_t frame;
+            size_t section;
+        };
+
+        core::FrameTimings& timings;
+        std::vector<GLuint> freeQueries;
+        std::deque<Pending> pending;
+        bool active = false;
+
+        void Read(const Pending& query);
+    public:
+        explicit GpuTimer(core::FrameTimings& timings);
+        ~GpuTimer();
+
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        void Begin(size_t section);
+        void End();
+        // Adds the results that are ready, call once per frame
+        void Collect();
+        // Waits for all results, before the timings are reported
+        void Finish();
+    };
+
+    class GpuScope {
+        GpuTimer& timer;
+    public:
+        GpuScope(GpuTimer& timer, size_t section);
+        ~GpuScope();
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+    };
+}
@@ -0,0 +1,124 @@
+#include "Headless.h"
+
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "core/Utility.h"
+
+namespace {
+    bool HasExtension(const char* extensions, const char* name)
+    {
+        const size_t length = strlen(name);
+        for (const char* p = extensions; p != nullptr && (p = strstr(p, name)) != nullptr; p += length)
+        {
+            if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+                return true;
+        }
+        return false;
+    }
+
+    EGLDisplay OpenDisplay()
+    {
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (getPlatformDisplay != nullptr)
+            {
+                EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                if (display != EGL_NO_DISPLAY)
+                    return display;
+            }
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+}
+
+glwrap::HeadlessContext::HeadlessContext(int widthArg, int heightArg)
+    : width(widthArg)
+    , height(heightArg)
+{
+    display = OpenDisplay();
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        throw GrafikaException("Failed to initialize EGL");
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        eglTerminate(display);
+        throw GrafikaException("EGL has no desktop OpenGL");
+    }
+
+    // Drivers with EGL_KHR_no_config_context also accept no config
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint configs = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configs);
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    context = eglCreateContext(display, configs > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        eglTerminate(display);
+        throw GrafikaException("Failed to create headless OpenGL 3.3 context");
+    }
+
+    glewExperimental = true;
+    const GLenum glewResult = glewInit();
+    // GLEW built for GLX still loads the GL functions without an X display
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    const bool glewLoaded = glewResult == GLEW_OK || glewResult == GLEW_ERROR_NO_GLX_DISPLAY;
+#else
+    const bool glewLoaded = glewResult == GLEW_OK;
+#endif
+    if (!glewLoaded)
+    {
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        throw GrafikaException("Failed to initialize glew");
+    }
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        throw GrafikaException("Offscreen framebuffer is incomplete");
+    }
+    glViewport(0, 0, width, height);
+}
+
+glwrap::HeadlessContext::~HeadlessContext()
+{
+    glDeleteRenderbuffers(2, renderbuffers);
+    glDeleteFramebuffers(1, &framebuffer);
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+int glwrap::HeadlessContext::Width() const
+{
+    return width;
+}
+
+int glwrap::HeadlessContext::Height() const
+{
+    return height;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <GL/glew.h>
+
+namespace glwrap{
+    // OpenGL 3.3 core context without a window, through EGL (the Mesa
+    // surfaceless platform when available). Everything is drawn into an
+    // offscreen framebuffer of the given size, which stays bound.
+    class HeadlessContext {
+        void* display = nullptr;
+        void* context = nullptr;
+        GLuint framebuffer = 0;
+        GLuint renderbuffers[2] = {0, 0};
+        int width, height;
+    public:
+        HeadlessContext(int width = 1280, int height = 768);
+        ~HeadlessContext();
+
+        HeadlessContext(const HeadlessContext&) = delete;
+        HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+        int Width() const;
+        int Height() const;
+    };
+}
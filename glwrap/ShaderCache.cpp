@@ -0,0 +1,215 @@
+#include "ShaderCache.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // File layout: magic, binary format, program binary
+    const char MAGIC[4] = {'G', 'P', 'B', '1'};
+
+    std::string EnvironmentPath(const char* name)
+    {
+        const char* value = getenv(name);
+        return value != nullptr && std::filesystem::path(value).is_absolute() ? value : "";
+    }
+
+    // Per user, other users must not be able to plant binaries in it
+    std::string DefaultCacheDirectory()
+    {
+#ifdef _WIN32
+        const std::string base = EnvironmentPath("LOCALAPPDATA");
+        return base.empty() ? base : (std::filesystem::path(base) / "grafika").string();
+#else
+        std::string base = EnvironmentPath("XDG_CACHE_HOME");
+        if (base.empty())
+        {
+            const std::string home = EnvironmentPath("HOME");
+            if (home.empty())
+                return home;
+            base = (std::filesystem::path(home) / ".cache").string();
+        }
+        return (std::filesystem::path(base) / "grafika").string();
+#endif
+    }
+
+    std::string& CacheDirectory()
+    {
+        static std::string directory = DefaultCacheDirectory();
+        return directory;
+    }
+
+    // True if the cache directory exists, or was created when create is set,
+    // and belongs to this user without being writable by others
+    bool UsableCacheDirectory(bool create)
+    {
+        const std::string& directory = CacheDirectory();
+        std::error_code error;
+#ifdef _WIN32
+        if (create)
+            std::filesystem::create_directories(directory, error);
+        return std::filesystem::is_directory(directory, error);
+#else
+        if (create)
+        {
+            std::filesystem::create_directories(std::filesystem::path(directory).parent_path(), error);
+            mkdir(directory.c_str(), 0700);
+        }
+        struct stat info;
+        return stat(directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == geteuid() &&
+               (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+#endif
+    }
+
+    // Unique among processes and threads writing the same entry
+    std::string TemporaryPath(const std::string& path)
+    {
+        static std::atomic<unsigned> counter{0};
+#ifdef _WIN32
+        const long long process = _getpid();
+#else
+        const long long process = getpid();
+#endif
+        return path + "." + std::to_string(process) + "." + std::to_string(counter++) + ".tmp";
+    }
+
+    std::string CachePath(const std::string& key)
+    {
+        return (std::filesystem::path(CacheDirectory()) / (key + ".bin")).string();
+    }
+
+    uint64_t Fnv1a(uint64_t hash, const std::string& data)
+    {
+        for (unsigned char c : data)
+        {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        // Separator, so that moving text between the parts changes the hash
+        return (hash ^ 0xff) * 1099511628211ULL;
+    }
+
+    std::string GLString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+    }
+}
+
+void glwrap::SetShaderCacheDirectory(const std::string& directory)
+{
+    CacheDirectory() = directory;
+}
+
+std::string glwrap::ShaderCacheKey(const std::string& vertexShaderCode, const std::string& fragmentShaderCode)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const std::string& part : {vertexShaderCode, fragmentShaderCode, GLString(GL_VENDOR),
+                                    GLString(GL_RENDERER), GLString(GL_VERSION)})
+    {
+        hash = Fnv1a(hash, part);
+    }
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+bool glwrap::ShaderCacheEnabled()
+{
+    if (CacheDirectory().empty() || !GLEW_ARB_get_program_binary)
+        return false;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+GLuint glwrap::LoadCachedProgram(const std::string& key)
+{
+    if (!ShaderCacheEnabled() || !UsableCacheDirectory(false))
+        return 0;
+
+    std::ifstream stream(CachePath(key), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+        return 0;
+    const std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    GLenum format;
+    const size_t header = sizeof(MAGIC) + sizeof(format);
+    if (data.size() <= header || memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+        return 0;
+    memcpy(&format, data.data() + sizeof(MAGIC), sizeof(format));
+
+    GLuint programId = glCreateProgram();
+    glProgramBinary(programId, format, data.data() + header, static_cast<GLsizei>(data.size() - header));
+    GLint result = GL_FALSE;
+    glGetProgramiv(programId, GL_LINK_STATUS, &result);
+    if (result != GL_TRUE)
+    {
+        // Stale blob, e.g. after a driver update with the same version string.
+        // An unknown format also raises GL_INVALID_ENUM, which is cleared.
+        glGetError();
+        glDeleteProgram(programId);
+        std::error_code error;
+        std::filesystem::remove(CachePath(key), error);
+        return 0;
+    }
+    return programId;
+}
+
+void glwrap::StoreCachedProgram(GLuint programId, const std::string& key)
+{
+    if (!ShaderCacheEnabled())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    GLenum format;
+    std::vector<char> data(sizeof(MAGIC) + sizeof(format) + static_cast<size_t>(length));
+    GLsizei written = 0;
+    glGetProgramBinary(programId, length, &written, &format, data.data() + sizeof(MAGIC) + sizeof(format));
+    if (written <= 0)
+        return;
+    memcpy(data.data(), MAGIC, sizeof(MAGIC));
+    memcpy(data.data() + sizeof(MAGIC), &format, sizeof(format));
+    data.resize(sizeof(MAGIC) + sizeof(format) + static_cast<size_t>(written));
+
+    // Written under a temporary name of its own, so that a concurrent run
+    // never reads half a file
+    if (!UsableCacheDirectory(true))
+        return;
+    std::error_code error;
+    const std::string path = CachePath(key);
+    const std::string temporary = TemporaryPath(path);
+    {
+        std::ofstream stream(temporary, std::ios::out | std::ios::binary);
+        stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!stream)
+        {
+            stream.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+
+namespace glwrap{
+    // Directory for linked program binaries, empty disables the cache.
+    // Defaults to grafika in $XDG_CACHE_HOME, ~/.cache or %LOCALAPPDATA%.
+    // It is created with mode 0700 and not used if another user owns it or
+    // can write to it.
+    void SetShaderCacheDirectory(const std::string& directory);
+
+    // Hash of both sources and the GL vendor, renderer and version strings,
+    // a driver update gives new keys
+    std::string ShaderCacheKey(const std::string& vertexShaderCode, const std::string& fragmentShaderCode);
+
+    // True if program binaries can be retrieved and the cache is enabled
+    bool ShaderCacheEnabled();
+
+    // New program from the cached binary, 0 if there is none or the driver
+    // rejects it
+    GLuint LoadCachedProgram(const std::string& key);
+
+    // Saves a linked program, which should have been linked with
+    // GL_PROGRAM_BINARY_RETRIEVABLE_HINT. Failures only leave the cache empty.
+    void StoreCachedProgram(GLuint programId, const std::string& key);
+}
@@ -0,0 +1,139 @@
+#include "StreamBuffer.h"
+
+#include <stdint.h>
+#include <algorithm>
+
+#include "core/Utility.h"
+
+namespace {
+    // Region offsets are kept aligned for any attribute type and mapping
+    const size_t REGION_ALIGNMENT = 256;
+}
+
+glwrap::StreamBuffer::StreamBuffer(GLenum targetArg, size_t frameBytes, unsigned regions)
+    : target(targetArg)
+    , regionSize(frameBytes)
+    , regionBytes((frameBytes + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT)
+    , regionCount(std::max(regions, 1u))
+    , current(regionCount - 1)
+    , fences(regionCount, nullptr)
+{
+    const auto totalBytes = static_cast<GLsizeiptr>(regionBytes * regionCount);
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    if (GLEW_ARB_buffer_storage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, totalBytes, nullptr, flags);
+        persistent = static_cast<char*>(glMapBufferRange(target, 0, totalBytes, flags));
+        if (persistent == nullptr)
+        {
+            throw GrafikaException("Failed to map stream buffer");
+        }
+    }
+    else
+    {
+        glBufferData(target, totalBytes, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+glwrap::StreamBuffer::~StreamBuffer()
+{
+    for (GLsync fence : fences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    if (persistent != nullptr)
+    {
+        glBindBuffer(target, buffer);
+        glUnmapBuffer(target);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void glwrap::StreamBuffer::Wait(unsigned region)
+{
+    GLsync& fence = fences[region];
+    if (fence == nullptr)
+    {
+        return;
+    }
+
+    GLbitfield flags = 0;
+    for (;;)
+    {
+        const GLenum status = glClientWaitSync(fence, flags, 1000000000);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        if (status == GL_WAIT_FAILED)
+        {
+            throw GrafikaException("Failed to wait for stream buffer fence");
+        }
+        // The fence may not have been flushed to the GPU yet
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void* glwrap::StreamBuffer::Map()
+{
+    current = (current + 1) % regionCount;
+    Wait(current);
+
+    if (persistent != nullptr)
+    {
+        return persistent + current * regionBytes;
+    }
+
+    glBindBuffer(target, buffer);
+    void* data = glMapBufferRange(target, static_cast<GLintptr>(current * regionBytes),
+                                  static_cast<GLsizeiptr>(regionSize),
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (data == nullptr)
+    {
+        throw GrafikaException("Failed to map stream buffer");
+    }
+    return data;
+}
+
+void glwrap::StreamBuffer::Unmap()
+{
+    glBindBuffer(target, buffer);
+    // Coherent persistent mappings need no flush
+    if (persistent == nullptr && glUnmapBuffer(target) == GL_FALSE)
+    {
+        throw GrafikaException("Stream buffer contents were lost while mapped");
+    }
+}
+
+void glwrap::StreamBuffer::Fence()
+{
+    // A second fence for the same use of the region replaces the first
+    GLsync& fence = fences[current];
+    if (fence != nullptr)
+    {
+        glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint glwrap::StreamBuffer::Id() const
+{
+    return buffer;
+}
+
+const void* glwrap::StreamBuffer::Offset() const
+{
+    return reinterpret_cast<const void*>(static_cast<uintptr_t>(current * regionBytes));
+}
+
+bool glwrap::StreamBuffer::IsPersistent() const
+{
+    return persistent != nullptr;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <stddef.h>
+#include <vector>
+
+namespace glwrap{
+    // Ring of regions in one buffer object for data rewritten every frame.
+    // With ARB_buffer_storage the buffer is mapped once, persistently,
+    // otherwise each region is mapped unsynchronized on its own. Fences keep
+    // the CPU from overwriting a region the GPU still reads.
+    //
+    //     float* data = static_cast<float*>(stream.Map());
+    //     ... write the frame ...
+    //     stream.Unmap();
+    //     glVertexAttribPointer(..., stream.Offset());
+    //     ... draw ...
+    //     stream.Fence();
+    class StreamBuffer {
+        GLenum target;
+        GLuint buffer = 0;
+        size_t regionSize;
+        size_t regionBytes;
+        unsigned regionCount;
+        unsigned current;
+        char* persistent = nullptr;
+        std::vector<GLsync> fences;
+
+        void Wait(unsigned region);
+    public:
+        StreamBuffer(GLenum target, size_t frameBytes, unsigned regions = 3);
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        // Moves to the next region and returns frameBytes of write only
+        // memory, waits only if the GPU is still reading that region
+        void* Map();
+        // Makes the written data visible, leaves the buffer bound to target
+        void Unmap();
+        // Call after the last draw reading the current region
+        void Fence();
+
+        GLuint Id() const;
+        // Byte offset of the current region, for glVertexAttribPointer
+        const void* Offset() const;
+        bool IsPersistent() const;
+    };
+}
@@ -1,9 +1,11 @@
 #include "Utility.h"
 
-#include <iostream>
+#include <algorithm>
 #include <vector>
 
+#include "core/Trace.h"
 #include "core/Utility.h"
+#include "ShaderCache.h"
 
 GLFWwindow* glwrap::CreateWindow(const std::string& name, int width, int height)
 {
@@ -40,47 +42,59 @@ GLFWwindow* glwrap::CreateWindow(const std::string& name, int width, int height)
 
 void glwrap::CompileShader(const std::string& code, GLuint shaderId)
 {
-    std::cout << "Compiling shader " << std::endl;
     const char * sourcePointer = code.c_str();
     glShaderSource(shaderId, 1, &sourcePointer, nullptr);
     glCompileShader(shaderId);
 
     GLint result = GL_FALSE;
-    int infoLength;
-    // Check Vertex Shader
     glGetShaderiv(shaderId, GL_COMPILE_STATUS, &result);
-    glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &infoLength);
-    if (infoLength > 0){
-        std::vector<char> infoMessage(static_cast<size_t>(infoLength+1));
+    if (result != GL_TRUE)
+    {
+        int infoLength = 0;
+        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &infoLength);
+        std::vector<char> infoMessage(static_cast<size_t>(std::max(infoLength, 0) + 1), '\0');
         glGetShaderInfoLog(shaderId, infoLength, nullptr, infoMessage.data());
-        std::cerr << infoMessage.data() << std::endl;
+        throw GrafikaException(std::string("Failed to compile shader:\n") + infoMessage.data());
     }
 }
 
 GLuint glwrap::LoadShaders(const std::string& vertexShaderCode, const std::string& fragmentShaderCode)
 {
+    core::TraceZone zone("Load shaders");
+    const std::string cacheKey = ShaderCacheKey(vertexShaderCode, fragmentShaderCode);
+    GLuint cachedId = LoadCachedProgram(cacheKey);
+    if (cachedId != 0)
+    {
+        return cachedId;
+    }
+
     GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
     GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
 
-    CompileShader(vertexShaderCode, vertexShaderId);
-    CompileShader(fragmentShaderCode, fragmentShaderId);
+    try
+    {
+        CompileShader(vertexShaderCode, vertexShaderId);
+        CompileShader(fragmentShaderCode, fragmentShaderId);
+    }
+    catch (...)
+    {
+        glDeleteShader(vertexShaderId);
+        glDeleteShader(fragmentShaderId);
+        throw;
+    }
 
-    std::cout << "Linking program" << std::endl;
     GLuint programId = glCreateProgram();
     glAttachShader(programId, vertexShaderId);
     glAttachShader(programId, fragmentShaderId);
+    const bool cache = ShaderCacheEnabled();
+    if (cache)
+    {
+        glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(programId);
 
-    GLint result;
-    int infoLength;
-
+    GLint result = GL_FALSE;
     glGetProgramiv(programId, GL_LINK_STATUS, &result);
-    glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &infoLength);
-    if (infoLength > 0){
-        std::vector<char> infoMessage(static_cast<size_t>(infoLength + 1));
-        glGetProgramInfoLog(programId, infoLength, NULL, infoMessage.data());
-        std::cerr << infoMessage.data() << std::endl;
-    }
 
     glDetachShader(programId, vertexShaderId);
     glDetachShader(programId, fragmentShaderId);
@@ -88,6 +102,21 @@ GLuint glwrap::LoadShaders(const std::string& vertexShaderCode, const std::strin
     glDeleteShader(vertexShaderId);
     glDeleteShader(fragmentShaderId);
 
+    if (result != GL_TRUE)
+    {
+        int infoLength = 0;
+        glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &infoLength);
+        std::vector<char> infoMessage(static_cast<size_t>(std::max(infoLength, 0) + 1), '\0');
+        glGetProgramInfoLog(programId, infoLength, nullptr, infoMessage.data());
+        glDeleteProgram(programId);
+        throw GrafikaException(std::string("Failed to link program:\n") + infoMessage.data());
+    }
+
+    if (cache)
+    {
+        StoreCachedProgram(programId, cacheKey);
+    }
+
     return programId;
 }
 
@@ -10,7 +10,10 @@
 namespace glwrap{
     GLFWwindow* CreateWindow(const std::string& name, int width = 1280, int height = 768);
 
+    // Throws GrafikaException with the info log if compilation fails
     void CompileShader(const std::string& code, GLuint shaderId);
 
+    // Linked program, from the shader cache when possible. Throws
+    // GrafikaException with the info log if compiling or linking fails.
     GLuint LoadShaders(const std::string& vertexShaderCode, const std::string& fragmentShaderCode);
 }